@@ -0,0 +1,528 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "ndef_bench.h"
+#include "ndef.h"
+#include "ndef_uri.h"
+#include "ndef_text.h"
+#include "ndef_smartposter.h"
+#include "ndef_record_types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_timer.h>
+#include <esp_cpu.h>
+#else
+#include <time.h>
+#endif
+
+
+
+// Minimum measuring time per benchmark in nanoseconds.
+#ifndef NDEF_BENCH_MIN_NS
+#ifdef ESP_PLATFORM
+#define NDEF_BENCH_MIN_NS 100000000ull
+#else
+#define NDEF_BENCH_MIN_NS 200000000ull
+#endif
+#endif
+
+// Record counts used for the message size sweep.
+static const size_t bench_sizes[] = { 1, 10, 100, 1000 };
+#define BENCH_SIZES (sizeof(bench_sizes) / sizeof(bench_sizes[0]))
+
+// One benchmark workload.
+typedef struct {
+	// Name shown in the results.
+	const char *name;
+	// Runs one operation.
+	void      (*run)(void *arg);
+	// Argument for `run`.
+	void       *arg;
+	// Bytes processed per operation.
+	size_t      bytes;
+} bench_case;
+
+
+
+#ifdef NDEF_BENCH_COUNT_ALLOCS
+// Number of allocations made so far.
+static size_t bench_allocs;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+// Counting wrapper around `malloc`, enabled with `-Wl,--wrap=malloc`.
+void *__wrap_malloc(size_t size) {
+	bench_allocs ++;
+	return __real_malloc(size);
+}
+
+// Counting wrapper around `calloc`, enabled with `-Wl,--wrap=calloc`.
+void *__wrap_calloc(size_t count, size_t size) {
+	bench_allocs ++;
+	return __real_calloc(count, size);
+}
+
+// Counting wrapper around `realloc`, enabled with `-Wl,--wrap=realloc`.
+void *__wrap_realloc(void *ptr, size_t size) {
+	bench_allocs ++;
+	return __real_realloc(ptr, size);
+}
+#endif
+
+// Get the current time in nanoseconds.
+static uint64_t bench_now() {
+#ifdef ESP_PLATFORM
+	return (uint64_t) esp_timer_get_time() * 1000;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+// Run a benchmark until it has taken long enough to measure and print the result.
+static void bench_measure(const bench_case *bench) {
+	// Warm up caches and lazily initialised state.
+	bench->run(bench->arg);
+	
+	size_t   iters = 1;
+	uint64_t elapsed;
+	size_t   allocs = 0;
+#ifdef ESP_PLATFORM
+	uint32_t cycles;
+#endif
+	while (1) {
+#ifdef NDEF_BENCH_COUNT_ALLOCS
+		size_t allocs_start = bench_allocs;
+#endif
+#ifdef ESP_PLATFORM
+		uint32_t cycles_start = esp_cpu_get_cycle_count();
+#endif
+		uint64_t start = bench_now();
+		for (size_t i = 0; i < iters; i++) {
+			bench->run(bench->arg);
+		}
+		elapsed = bench_now() - start;
+#ifdef ESP_PLATFORM
+		cycles  = esp_cpu_get_cycle_count() - cycles_start;
+#endif
+#ifdef NDEF_BENCH_COUNT_ALLOCS
+		allocs  = bench_allocs - allocs_start;
+#endif
+		if (elapsed >= NDEF_BENCH_MIN_NS) break;
+		iters *= 2;
+	}
+	
+	double ns_per_op = (double) elapsed / iters;
+	double mb_per_s  = bench->bytes * 1000.0 / ns_per_op;
+	printf("%-32s %10zu %12.1f ns/op %10.2f MB/s", bench->name, iters, ns_per_op, mb_per_s);
+#ifdef NDEF_BENCH_COUNT_ALLOCS
+	printf(" %8.2f allocs/op", (double) allocs / iters);
+#else
+	(void) allocs;
+	printf("        - allocs/op");
+#endif
+#ifdef ESP_PLATFORM
+	// The 32-bit cycle counter wraps after a few seconds, so this is only meaningful for short runs.
+	printf(" %10.1f cycles/op", (double) cycles / iters);
+#endif
+	printf("\n");
+}
+
+
+
+// Build a message with `count` alternating URI and text records.
+static ndef_ctx bench_make_message(size_t count) {
+	ndef_ctx ctx = ndef_init();
+	if (!ctx) return NULL;
+	for (size_t i = 0; i < count; i++) {
+		char buf[64];
+		if (i % 2 == 0) {
+			snprintf(buf, sizeof(buf), "https://www.example.com/item/%zu", i);
+			ndef_append_mv(ctx, ndef_record_new_uri(buf));
+		} else {
+			snprintf(buf, sizeof(buf), "Item number %zu", i);
+			ndef_append_mv(ctx, ndef_record_new_text((ndef_text) { .lang = "en", .text = buf }));
+		}
+	}
+	return ctx;
+}
+
+// An encoded message and the context it was made from.
+typedef struct {
+	// Context holding the abstract records.
+	ndef_ctx ctx;
+	// Encoded message.
+	uint8_t *data;
+	// Length of the encoded message.
+	size_t   len;
+	// Reusable context for the `_into` variants.
+	ndef_ctx reuse;
+	// Reusable output buffer for `ndef_encode_into`.
+	uint8_t *out;
+} bench_message;
+
+static void bench_decode_copy(void *arg) {
+	bench_message *msg = arg;
+	size_t len = msg->len;
+	ndef_ctx ctx = ndef_decode(msg->data, &len);
+	if (ctx) ndef_destroy(ctx);
+}
+
+static void bench_decode_view(void *arg) {
+	bench_message *msg = arg;
+	size_t len = msg->len;
+	ndef_ctx ctx = ndef_decode_view(msg->data, &len);
+	if (ctx) ndef_destroy(ctx);
+}
+
+static void bench_decode_arena(void *arg) {
+	bench_message *msg = arg;
+	size_t len = msg->len;
+	ndef_ctx ctx = ndef_decode_arena(msg->data, &len);
+	if (ctx) ndef_destroy(ctx);
+}
+
+static void bench_decode_arena_into(void *arg) {
+	bench_message *msg = arg;
+	size_t len = msg->len;
+	ndef_decode_arena_into(msg->reuse, msg->data, &len);
+}
+
+static void bench_encode(void *arg) {
+	bench_message *msg = arg;
+	uint8_t *data;
+	size_t   len;
+	if (ndef_encode(msg->ctx, &data, &len)) ndef_free(data, NDEF_ALLOC_OUTPUT);
+}
+
+static void bench_encode_into(void *arg) {
+	bench_message *msg = arg;
+	size_t len;
+	ndef_encode_into(msg->ctx, msg->out, msg->len, &len);
+}
+
+// Check that a plain encode after a decode leaves the baseline intact, so a diff finds no changes.
+static bool bench_check_diff() {
+	bool        ok   = false;
+	ndef_ctx    src  = bench_make_message(10);
+	ndef_ctx    ctx  = ndef_init();
+	uint8_t    *data = NULL, *out = NULL, *diff = NULL;
+	size_t      len  = 0, out_len, diff_len;
+	ndef_range *ranges = NULL;
+	size_t      ranges_len = 0;
+	
+	if (src && ctx && ndef_encode(src, &data, &len)) {
+		size_t dec_len = len;
+		out = malloc(len);
+		ok  = out
+			&& ndef_decode_view_into(ctx, data, &dec_len)
+			&& ndef_encode_into(ctx, out, len, &out_len)
+			&& !ndef_record_is_dirty(ctx, 0)
+			&& ndef_encode_diff(ctx, 4, 0, &diff, &diff_len, &ranges, &ranges_len)
+			&& ranges_len == 0 && diff_len == len && !memcmp(diff, data, len);
+	}
+	if (!ok) printf("Check failed: encoding after a decode changed the diff baseline\n");
+	
+	if (ranges) ndef_free(ranges, NDEF_ALLOC_OUTPUT);
+	if (diff)   ndef_free(diff,   NDEF_ALLOC_OUTPUT);
+	free(out);
+	if (data)   ndef_free(data,   NDEF_ALLOC_OUTPUT);
+	if (ctx)    ndef_destroy(ctx);
+	if (src)    ndef_destroy(src);
+	return ok;
+}
+
+// Run the decode and encode benchmarks over all message sizes.
+static void bench_messages() {
+	printf("\nDecode / encode, alternating URI and text records:\n");
+	for (size_t i = 0; i < BENCH_SIZES; i++) {
+		bench_message msg = { .ctx = bench_make_message(bench_sizes[i]) };
+		if (!msg.ctx || !ndef_encode(msg.ctx, &msg.data, &msg.len)) {
+			printf("Failed to build a message of %zu records\n", bench_sizes[i]);
+			if (msg.ctx) ndef_destroy(msg.ctx);
+			continue;
+		}
+		msg.reuse = ndef_init();
+		msg.out   = malloc(msg.len);
+		
+		static const struct {
+			const char *name;
+			void      (*run)(void *arg);
+		} workloads[] = {
+			{ "decode",            bench_decode_copy },
+			{ "decode_view",       bench_decode_view },
+			{ "decode_arena",      bench_decode_arena },
+			{ "decode_arena_into", bench_decode_arena_into },
+			{ "encode",            bench_encode },
+			{ "encode_into",       bench_encode_into },
+		};
+		for (size_t x = 0; x < sizeof(workloads) / sizeof(workloads[0]); x++) {
+			if (!msg.reuse || !msg.out) break;
+			char name[48];
+			snprintf(name, sizeof(name), "%s/%zu", workloads[x].name, bench_sizes[i]);
+			bench_measure(&(bench_case) { name, workloads[x].run, &msg, msg.len });
+		}
+		
+		free(msg.out);
+		if (msg.reuse) ndef_destroy(msg.reuse);
+		ndef_free(msg.data, NDEF_ALLOC_OUTPUT);
+		ndef_destroy(msg.ctx);
+	}
+}
+
+
+
+// URIs covering short, long and missing abbreviations.
+static const char *const bench_uris[] = {
+	"https://www.example.com/",
+	"http://example.com/index.html",
+	"tel:+31612345678",
+	"mailto:someone@example.com",
+	"urn:nfc:sn:12345678",
+	"urn:epc:id:sgtin:0614141.107346.2017",
+	"geo:52.0116,4.3571",
+	"spotify:track:4uLU6hMCjMI75M1A2tKUQC",
+};
+#define BENCH_URIS (sizeof(bench_uris) / sizeof(bench_uris[0]))
+
+static void bench_uri_new(void *arg) {
+	(void) arg;
+	for (size_t i = 0; i < BENCH_URIS; i++) {
+		ndef_record_destroy(ndef_record_new_uri(bench_uris[i]));
+	}
+}
+
+static void bench_uri_get_into(void *arg) {
+	const ndef_record *records = arg;
+	char buf[64];
+	for (size_t i = 0; i < BENCH_URIS; i++) {
+		ndef_record_get_uri_into(records[i], buf, sizeof(buf));
+	}
+}
+
+static void bench_uri_get(void *arg) {
+	const ndef_record *records = arg;
+	for (size_t i = 0; i < BENCH_URIS; i++) {
+		ndef_free(ndef_record_get_uri(records[i]), NDEF_ALLOC_OUTPUT);
+	}
+}
+
+// Run the URI construction and extraction benchmarks.
+static void bench_uris_run() {
+	printf("\nURI records, %zu URIs per op:\n", BENCH_URIS);
+	ndef_record records[BENCH_URIS];
+	size_t      bytes = 0;
+	for (size_t i = 0; i < BENCH_URIS; i++) {
+		records[i]  = ndef_record_new_uri(bench_uris[i]);
+		bytes      += strlen(bench_uris[i]);
+	}
+	bench_measure(&(bench_case) { "uri_new",      bench_uri_new,      NULL,    bytes });
+	bench_measure(&(bench_case) { "uri_get_into", bench_uri_get_into, records, bytes });
+	bench_measure(&(bench_case) { "uri_get",      bench_uri_get,      records, bytes });
+	for (size_t i = 0; i < BENCH_URIS; i++) {
+		ndef_record_destroy(records[i]);
+	}
+}
+
+
+
+// A text record and a buffer to extract it into.
+typedef struct {
+	// The text record.
+	ndef_record record;
+	// Output buffer.
+	char        buf[256];
+} bench_text;
+
+static void bench_text_get_into(void *arg) {
+	bench_text *text = arg;
+	ndef_record_get_text_into(text->record, text->buf, sizeof(text->buf));
+}
+
+static void bench_text_get(void *arg) {
+	bench_text *text = arg;
+	ndef_text_destroy(ndef_record_get_text(text->record));
+}
+
+// Run the text extraction benchmarks for UTF-8 and UTF-16 records.
+static void bench_texts_run() {
+	printf("\nText records:\n");
+	static const char sample[] = "The quick brown fox jumps over the lazy dog. 0123456789";
+	size_t sample_len = sizeof(sample) - 1;
+	
+	// UTF-8 record.
+	bench_text utf8 = { .record = ndef_record_new_text((ndef_text) { .lang = "en", .text = (char *) sample }) };
+	
+	// UTF-16 record with a byte order mark, built by hand since the encoder only makes UTF-8.
+	bench_text utf16 = { .record = ndef_record_init() };
+	size_t   utf16_len = 1 + 2 + 2 + sample_len * 2;
+	uint8_t *payload   = ndef_malloc(utf16_len, NDEF_ALLOC_PAYLOAD);
+	uint8_t *type      = ndef_malloc(1, NDEF_ALLOC_FIELD);
+	if (payload && type) {
+		payload[0] = 0x80 | 2;
+		payload[1] = 'e';
+		payload[2] = 'n';
+		payload[3] = 0xfe;
+		payload[4] = 0xff;
+		for (size_t i = 0; i < sample_len; i++) {
+			payload[5 + i * 2] = 0;
+			payload[6 + i * 2] = sample[i];
+		}
+		type[0] = 'T';
+		utf16.record = (ndef_record) {
+			.tnf         = NDEF_TNF_WELL_KNOWN,
+			.type_len    = 1,
+			.payload_len = utf16_len,
+			.type        = type,
+			.payload     = payload,
+		};
+	} else {
+		ndef_free(payload, NDEF_ALLOC_PAYLOAD);
+		ndef_free(type, NDEF_ALLOC_FIELD);
+	}
+	
+	bench_measure(&(bench_case) { "text_get_into/utf8",  bench_text_get_into, &utf8,  sample_len });
+	bench_measure(&(bench_case) { "text_get/utf8",       bench_text_get,      &utf8,  sample_len });
+	if (utf16.record.payload) {
+		bench_measure(&(bench_case) { "text_get_into/utf16", bench_text_get_into, &utf16, sample_len * 2 });
+		bench_measure(&(bench_case) { "text_get/utf16",      bench_text_get,      &utf16, sample_len * 2 });
+	}
+	
+	ndef_record_destroy(utf8.record);
+	ndef_record_destroy(utf16.record);
+}
+
+
+
+// Build a smart poster nested `depth` levels deep, each level with its own URI and title.
+static ndef_record bench_make_poster(size_t depth) {
+	ndef_smartposter poster = ndef_smartposter_init();
+	poster.ndef = ndef_init();
+	if (!poster.ndef) return ndef_record_init();
+	if (depth > 1) {
+		ndef_append_mv(poster.ndef, bench_make_poster(depth - 1));
+	}
+	char uri[48];
+	char title[32];
+	snprintf(uri, sizeof(uri), "https://www.example.com/poster/%zu", depth);
+	snprintf(title, sizeof(title), "Poster level %zu", depth);
+	poster.uri  = uri;
+	poster.text = (ndef_text) { .lang = "en", .text = title };
+	
+	ndef_record record = ndef_record_new_smartposter(poster);
+	ndef_destroy(poster.ndef);
+	return record;
+}
+
+// Walk a smart poster and all nested smart posters in it without copying.
+static void bench_walk_poster_view(ndef_record record) {
+	ndef_smartposter_view view;
+	if (!ndef_record_get_smartposter_view(record, &view)) return;
+	ndef_ctx inner = ndef_smartposter_view_decode(&view);
+	if (!inner) return;
+	for (size_t i = 0; i < ndef_records_len(inner); i++) {
+		if (ndef_records(inner)[i].kind == NDEF_KIND_SMARTPOSTER) {
+			bench_walk_poster_view(ndef_records(inner)[i]);
+		}
+	}
+	ndef_destroy(inner);
+}
+
+// Walk a smart poster and all nested smart posters in it, decoding copies.
+static void bench_walk_poster(ndef_record record) {
+	ndef_smartposter poster = ndef_record_get_smartposter(record);
+	if (poster.ndef) {
+		for (size_t i = 0; i < ndef_records_len(poster.ndef); i++) {
+			if (ndef_records(poster.ndef)[i].kind == NDEF_KIND_SMARTPOSTER) {
+				bench_walk_poster(ndef_records(poster.ndef)[i]);
+			}
+		}
+	}
+	ndef_smartposter_destroy(poster);
+}
+
+static void bench_poster_view(void *arg) {
+	bench_walk_poster_view(*(const ndef_record *) arg);
+}
+
+static void bench_poster_get(void *arg) {
+	bench_walk_poster(*(const ndef_record *) arg);
+}
+
+static void bench_poster_new(void *arg) {
+	ndef_record_destroy(bench_make_poster(*(const size_t *) arg));
+}
+
+// Run the smart poster benchmarks for a few nesting depths.
+static void bench_posters_run() {
+	printf("\nNested smart posters:\n");
+	static const size_t depths[] = { 1, 4 };
+	for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+		ndef_record record = bench_make_poster(depths[i]);
+		if (!record.payload) {
+			printf("Failed to build a smart poster of depth %zu\n", depths[i]);
+			continue;
+		}
+		char name[48];
+		snprintf(name, sizeof(name), "poster_view/%zu", depths[i]);
+		bench_measure(&(bench_case) { name, bench_poster_view, &record, record.payload_len });
+		snprintf(name, sizeof(name), "poster_get/%zu", depths[i]);
+		bench_measure(&(bench_case) { name, bench_poster_get, &record, record.payload_len });
+		snprintf(name, sizeof(name), "poster_new/%zu", depths[i]);
+		bench_measure(&(bench_case) { name, bench_poster_new, (void *) &depths[i], record.payload_len });
+		ndef_record_destroy(record);
+	}
+}
+
+
+
+// Run all benchmarks and print the results.
+// On ESP-IDF, call this from the application after enabling `CONFIG_NDEF_BENCH`.
+void ndef_bench_run() {
+	bench_check_diff();
+	printf("%-32s %10s %15s %15s %18s\n", "benchmark", "iters", "time", "throughput", "allocations");
+	bench_messages();
+	bench_uris_run();
+	bench_texts_run();
+	bench_posters_run();
+}
+
+#ifndef ESP_PLATFORM
+// Pass `--check` to only run the checks, as ctest does.
+int main(int argc, char **argv) {
+	if (argc > 1 && !strcmp(argv[1], "--check")) {
+		return bench_check_diff() ? 0 : 1;
+	}
+	ndef_bench_run();
+	return 0;
+}
+#endif
@@ -25,10 +25,13 @@
 #pragma once
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 
+#include "ndef_alloc.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -69,48 +72,195 @@ typedef enum {
 // LUT from ndef_tnf to name.
 extern const char *ndef_tnf_names[8];
 
+// Define `NDEF_COMPACT_RECORDS` for the entire build to store records in a packed layout.
+// This limits a message to 65535 records and payloads to 32-bit lengths, like the wire format.
+#ifdef NDEF_COMPACT_RECORDS
+// Storage type for a TNF in records.
+typedef uint8_t  ndef_tnf_t;
+// Storage type for record indices.
+typedef uint16_t ndef_index_t;
+// Storage type for payload lengths.
+typedef uint32_t ndef_len_t;
+// Storage width for record flags.
+#define NDEF_FLAG_BITS		: 1
+// Maximum number of raw or abstract records in a context.
+#define NDEF_MAX_RECORDS	UINT16_MAX
+// Maximum length of an abstract record's payload.
+#define NDEF_MAX_PAYLOAD	UINT32_MAX
+#else
+// Storage type for a TNF in records.
+typedef ndef_tnf ndef_tnf_t;
+// Storage type for record indices.
+typedef size_t   ndef_index_t;
+// Storage type for payload lengths.
+typedef size_t   ndef_len_t;
+// Storage width for record flags.
+#define NDEF_FLAG_BITS
+// Maximum number of raw or abstract records in a context.
+#define NDEF_MAX_RECORDS	SIZE_MAX
+// Maximum length of an abstract record's payload.
+#define NDEF_MAX_PAYLOAD	SIZE_MAX
+#endif
+
+// Bitmask for `ndef_record.borrowed`: the type is not owned by the record.
+#define NDEF_BORROW_TYPE	0x01
+// Bitmask for `ndef_record.borrowed`: the payload is not owned by the record.
+#define NDEF_BORROW_PAYLOAD	0x02
+// Bitmask for `ndef_record.borrowed`: the ID is not owned by the record.
+#define NDEF_BORROW_ID		0x04
+// Bitmask for `ndef_record.borrowed`: no fields are owned by the record.
+#define NDEF_BORROW_ALL		0x07
+
+// Reason why an NDEF operation failed.
+typedef enum {
+	// No error.
+	NDEF_OK,
+	// The data ends in the middle of a record.
+	NDEF_ERR_TRUNCATED,
+	// Chunked records do not form a valid sequence.
+	NDEF_ERR_CHUNK,
+	// The MB flag is missing from the first record or present on a later one.
+	NDEF_ERR_FLAGS,
+	// Too many records or too much payload data.
+	NDEF_ERR_TOO_LONG,
+	// Out of memory.
+	NDEF_ERR_NO_MEM,
+	// The output buffer is too small.
+	NDEF_ERR_NO_SPACE,
+	// The write callback aborted encoding.
+	NDEF_ERR_WRITE,
+	// Invalid argument.
+	NDEF_ERR_INVALID,
+	// The read callback failed.
+	NDEF_ERR_READ,
+} ndef_err;
+
+// LUT from ndef_err to name.
+extern const char *ndef_err_names[10];
+
+// Summary of a blob of NDEF data as determined by `ndef_validate`.
+// If the data is invalid, everything except the error describes the complete records before the error.
+typedef struct {
+	// Number of raw records.
+	size_t   raw_records;
+	// Number of abstract records, where a chunked record counts once.
+	size_t   records;
+	// Total length of the type fields.
+	size_t   type_bytes;
+	// Total length of the payload fields.
+	size_t   payload_bytes;
+	// Total length of the ID fields.
+	size_t   id_bytes;
+	// Length of the message, up to and including the record with the ME flag.
+	size_t   encoded_len;
+	// Reason the data is invalid, or `NDEF_OK`.
+	ndef_err error;
+	// Offset of the raw record that makes the data invalid.
+	size_t   error_offset;
+} ndef_validate_info;
+
+// Severity of a diagnostic message.
+typedef enum {
+	// An operation failed.
+	NDEF_LOG_ERROR,
+	// Something noteworthy that is not an error.
+	NDEF_LOG_NOTE,
+	// Details for debugging.
+	NDEF_LOG_DEBUG,
+} ndef_log_level;
+
+// Receives diagnostic messages if the library is built with `NDEF_ENABLE_LOG`.
+// `msg` has no trailing newline and is only valid for the duration of the call.
+typedef void (*ndef_log_cb)(void *cookie, ndef_log_level level, const char *msg);
+
+// Phases of decoding and encoding that are measured if the library is built with `NDEF_ENABLE_STATS`.
+typedef enum {
+	// Anything outside the other phases; never reported to the phase hooks.
+	NDEF_PHASE_OTHER,
+	// Checking a message and sizing it up before decoding.
+	NDEF_PHASE_VALIDATE,
+	// Allocating memory up front for decoding or encoding.
+	NDEF_PHASE_RESERVE,
+	// Parsing the headers of a record.
+	NDEF_PHASE_HEADER,
+	// Storing the type, payload and ID of a decoded record.
+	NDEF_PHASE_COPY,
+	// Inserting abstract records into a context.
+	NDEF_PHASE_APPEND,
+	// Writing encoded records to the output.
+	NDEF_PHASE_ENCODE,
+	// Number of phases.
+	NDEF_PHASE_COUNT,
+} ndef_phase;
+
+// LUT from ndef_phase to name.
+extern const char *ndef_phase_names[NDEF_PHASE_COUNT];
+
+// Counters for one phase.
+typedef struct {
+	// Number of times the phase was entered.
+	size_t calls;
+	// Number of `malloc` and `realloc` calls made during the phase.
+	size_t allocs;
+	// Number of bytes requested by those calls.
+	size_t alloc_bytes;
+} ndef_phase_stats;
+
+// Counters for all phases, collected across all threads.
+typedef struct {
+	ndef_phase_stats phase[NDEF_PHASE_COUNT];
+} ndef_stats;
+
+// Called when a phase begins or ends if the library is built with `NDEF_ENABLE_STATS`.
+// Phases do not nest, but different threads may be in different phases at the same time.
+typedef void (*ndef_phase_cb)(void *cookie, ndef_phase phase);
+
 
 // Abstract NDEF record without encoding details.
 typedef struct {
 	// Index of corresponding raw record.
-	size_t   raw_index;
+	ndef_index_t raw_index;
 	// Number of raw records used to make this record.
-	size_t   raw_len;
+	ndef_index_t raw_len;
 	
 	// Type of data in this record.
-	ndef_tnf tnf;
+	ndef_tnf_t   tnf;
+	// Classified kind of record (`ndef_kind`), or 0 if not classified yet.
+	uint8_t      kind;
+	// Fields that are borrowed rather than owned (`NDEF_BORROW_*`), and therefore not freed.
+	uint8_t      borrowed;
 	
 	// Length of the type field.
-	uint8_t  type_len;
+	uint8_t      type_len;
 	// Length of the payload field.
-	size_t   payload_len;
+	ndef_len_t   payload_len;
 	// Length of the ID field.
-	uint8_t  id_len;
+	uint8_t      id_len;
 	
 	// User-specified payload type.
-	uint8_t *type;
+	uint8_t     *type;
 	// User-specified payload.
-	uint8_t *payload;
+	uint8_t     *payload;
 	// User-specified ID.
-	uint8_t *id;
+	uint8_t     *id;
 } ndef_record;
 
 
 // Encoding details for an NDEF record.
 typedef struct {
 	// Index of corresponding abstract record.
-	size_t   abs_index;
+	ndef_index_t abs_index;
 	
 	// First record flag.
-	bool     flag_begin;
+	bool         flag_begin NDEF_FLAG_BITS;
 	// Last record flag.
-	bool     flag_end;
+	bool         flag_end NDEF_FLAG_BITS;
 	// Chunked data flag.
-	bool     flag_chunked;
+	bool         flag_chunked NDEF_FLAG_BITS;
 	// Short record flag.
-	bool     flag_short_record;
+	bool         flag_short_record NDEF_FLAG_BITS;
 	// Includes ID length flag.
-	bool     flag_include_id_len;
+	bool         flag_include_id_len NDEF_FLAG_BITS;
 } ndef_enc_detail;
 
 
@@ -123,26 +273,30 @@ typedef struct {
 		
 		struct {
 			// Index of corresponding raw record.
-			size_t   raw_index;
+			ndef_index_t raw_index;
 			// Number of raw records used to make this record.
-			size_t   raw_len;
+			ndef_index_t raw_len;
 			
 			// Type of data in this record.
-			ndef_tnf tnf;
+			ndef_tnf_t   tnf;
+			// Classified kind of record (`ndef_kind`), or 0 if not classified yet.
+			uint8_t      kind;
+			// Fields that are borrowed rather than owned (`NDEF_BORROW_*`), and therefore not freed.
+			uint8_t      borrowed;
 			
 			// Length of the type field.
-			uint8_t  type_len;
+			uint8_t      type_len;
 			// Length of the payload field.
-			size_t   payload_len;
+			ndef_len_t   payload_len;
 			// Length of the ID field.
-			uint8_t  id_len;
+			uint8_t      id_len;
 			
 			// User-specified payload type.
-			uint8_t *type;
+			uint8_t     *type;
 			// User-specified payload.
-			uint8_t *payload;
+			uint8_t     *payload;
 			// User-specified ID.
-			uint8_t *id;
+			uint8_t     *id;
 		};
 	};
 	
@@ -153,40 +307,63 @@ typedef struct {
 		
 		struct {
 			// Index of corresponding abstract record.
-			size_t   abs_index;
+			ndef_index_t abs_index;
 			
 			// First record flag.
-			bool     flag_begin;
+			bool         flag_begin NDEF_FLAG_BITS;
 			// Last record flag.
-			bool     flag_end;
+			bool         flag_end NDEF_FLAG_BITS;
 			// Chunked data flag.
-			bool     flag_chunked;
+			bool         flag_chunked NDEF_FLAG_BITS;
 			// Short record flag.
-			bool     flag_short_record;
+			bool         flag_short_record NDEF_FLAG_BITS;
 			// Includes ID length flag.
-			bool     flag_include_id_len;
+			bool         flag_include_id_len NDEF_FLAG_BITS;
 		};
 	};
 } ndef_raw_record;
 
 
+// Compact encoding details for a raw record, kept instead of a full copy of it.
+typedef struct {
+	// Flags and index of corresponding abstract record.
+	ndef_enc_detail detail;
+	// Offset of this raw record's part of the abstract record's payload.
+	ndef_len_t      payload_offset;
+	// Length of this raw record's part of the abstract record's payload.
+	ndef_len_t      payload_len;
+	// Offset of this raw record in the baseline encoding, or all ones if not from it.
+	ndef_len_t      enc_offset;
+} ndef_enc_entry;
+
+
 
 #ifdef NDEF_REVEAL_PRIVATE
 
 // Magic value as in ndef_ctx.
 #define NDEF_MAGIC 0xdeadbeef
 
+// Reference-counted record data shared by cloned contexts.
+typedef struct ndef_pool_s ndef_pool;
+
 // All context required to read and write NDEF messages.
 typedef struct {
 	// Magic value.
 	uint32_t     magic;
+	// Allocator for the context itself, its arrays and its arena.
+	const ndef_allocator *alloc;
+	
+	// Number of raw NDEF records.
+	size_t       enc_len;
+	// Capacity for raw NDEF records.
+	size_t       enc_cap;
+	// Encoding details of raw NDEF records.
+	ndef_enc_entry *enc;
 	
-	// Number of NDEF records.
-	size_t       raw_records_len;
-	// Capacity for NDEF record pointers.
-	size_t       raw_records_cap;
-	// NDEF record pointers.
-	ndef_raw_record *raw_records;
+	// Capacity of `raw_cache`.
+	size_t       raw_cache_cap;
+	// Raw NDEF records reconstructed by `ndef_raw_records`.
+	ndef_raw_record *raw_cache;
 	
 	// Number of abstract NDEF records.
 	size_t       abs_records_len;
@@ -194,18 +371,53 @@ typedef struct {
 	size_t       abs_records_cap;
 	// Abstract NDEF record pointers.
 	ndef_record *abs_records;
+	
+	// Bump-allocated storage for record data, if any.
+	uint8_t     *arena;
+	// Number of bytes used in the arena.
+	size_t       arena_len;
+	// Capacity of the arena.
+	size_t       arena_cap;
+	// Shared record data that the borrowed records may point into, if any.
+	ndef_pool   *pool;
+	
+	// Maximum payload size per raw record when encoding, or 0 for no chunking.
+	size_t       chunk_size;
+	// Length of the encoding the raw records were decoded from or last diffed against, if any.
+	size_t       base_len;
+	// Incremented every time the abstract records or the chunk size change.
+	uint32_t     generation;
+	// Whether the context and its arrays and arena are caller storage of fixed size.
+	bool         fixed;
+	
+	// Reason the last failed operation failed.
+	ndef_err     error;
+	// Offset in the data at which the last failed operation failed.
+	size_t       error_offset;
 } ndef_ctx_s;
 
 // All context required to read and write NDEF messages.
 typedef ndef_ctx_s *ndef_ctx;
 
-// Append a raw NDEF record.
+// Append the encoding details of a raw NDEF record.
 bool		ndef_raw_append		(ndef_ctx ctx, ndef_raw_record record);
-// Clone an ndef_raw_record.
-bool		ndef_record_clone	(ndef_record in, ndef_record *out);
-// Parse a single NDEF record from a blob of data.
+// Decode a single NDEF record from a blob of data without copying.
 // Sets `len` to the amount of successfully decoded data when finished.
-bool		ndef_record_parse	(ndef_raw_record *out, uint8_t *data, size_t *len);
+bool		ndef_raw_record_decode_view(ndef_raw_record *out, uint8_t *data, size_t *len);
+
+// Maximum length of an encoded record header.
+#define NDEF_RAW_HEADER_MAX 7
+
+// Determine the encoded size of a single NDEF record.
+size_t		ndef_raw_record_size(const ndef_raw_record *data);
+// Encode the header of a single NDEF record into `header`, which has room for `NDEF_RAW_HEADER_MAX` bytes.
+// Returns the length of the header.
+size_t		ndef_raw_record_encode_header(const ndef_raw_record *data, uint8_t *header);
+// Determine the number of chunks used to encode abstract record `index`.
+size_t		ndef_enc_chunk_count(ndef_ctx ctx, size_t index);
+// Make the raw record used to encode chunk `chunk` of `chunks` of abstract record `index`.
+ndef_raw_record
+			ndef_make_raw		(ndef_ctx ctx, size_t index, size_t chunk, size_t chunks);
 
 #else
 
@@ -214,28 +426,151 @@ typedef void *ndef_ctx;
 
 #endif
 
+// Called by the streaming encoder to write out encoded data.
+// Return false to abort encoding.
+typedef bool (*ndef_write_cb)(void *cookie, const uint8_t *data, size_t len);
+
+// A range of bytes in an encoded message.
+typedef struct {
+	// Offset of the first byte.
+	size_t offset;
+	// Number of bytes.
+	size_t len;
+} ndef_range;
+
+// Size of `ndef_ctx_storage` in pointer-sized words.
+#ifndef NDEF_CTX_STORAGE_WORDS
+#define NDEF_CTX_STORAGE_WORDS 24
+#endif
+
+// Caller-provided memory for a context; checked at compile time to be large enough.
+typedef struct {
+	// Opaque.
+	union {
+		void    *ptr;
+		size_t   size;
+		uint64_t u64;
+	} words[NDEF_CTX_STORAGE_WORDS];
+} ndef_ctx_storage;
+
+// Declare storage for a context of up to `max_records` raw records that never uses the heap.
+// Put it in static memory, then create the context with `NDEF_STATIC_CTX_INIT(name)`.
+#define NDEF_STATIC_CTX(name, max_records) \
+	struct { \
+		ndef_ctx_storage storage; \
+		ndef_record      records[max_records]; \
+		ndef_enc_entry   enc[max_records]; \
+		ndef_raw_record  raw_cache[max_records]; \
+	} name
+// Create a context in storage declared with `NDEF_STATIC_CTX`, without an arena.
+#define NDEF_STATIC_CTX_INIT(name) \
+	NDEF_STATIC_CTX_INIT_ARENA(name, NULL, 0)
+// Create a context in storage declared with `NDEF_STATIC_CTX`, with an arena of `arena_len` bytes at `arena`.
+#define NDEF_STATIC_CTX_INIT_ARENA(name, arena, arena_len) \
+	ndef_init_static( \
+		&(name).storage, sizeof((name).records) / sizeof(ndef_record), \
+		(name).records, (name).enc, (name).raw_cache, (arena), (arena_len) \
+	)
+
 
 // Create an empty NDEF codec context.
 ndef_ctx	ndef_init			();
+// Create an empty NDEF codec context that keeps its record arrays and arena in memory from `alloc`.
+// Record data other than the arena comes from the global allocator; `alloc` must outlive the context.
+ndef_ctx	ndef_init_alloc		(const ndef_allocator *alloc);
+// Create an empty NDEF codec context in caller storage that never allocates; see `NDEF_STATIC_CTX`.
+// It holds up to `max_records` raw records; all arrays must have that many entries.
+// Chunked payloads are concatenated and arena decodes are copied into `arena`, which may be NULL.
+// Decoding with `ndef_decode_view_into` or `ndef_decode_arena_into`, moving records in with the `_mv` functions
+// and encoding with `ndef_encode_into` or `ndef_encode_stream` then take time bounded by the data and `max_records`.
+// `ndef_encode_diff` is not available; `ndef_clone` copies the records into a context on the heap.
+ndef_ctx	ndef_init_static	(ndef_ctx_storage *storage, size_t max_records,
+								ndef_record *records, ndef_enc_entry *enc, ndef_raw_record *raw_cache,
+								uint8_t *arena, size_t arena_len);
 // Create a clone of an NDEF codec context.
+// The record data is shared between both contexts, so this copies only the record arrays.
+// Ownership of the record data in `ctx` moves to the shared pool, so `ctx` must not be in use elsewhere meanwhile.
 ndef_ctx	ndef_clone			(ndef_ctx ctx);
 // Destroy an NDEF codec context.
 void		ndef_destroy		(ndef_ctx ctx);
 // Print a hierarchical info about this NDEF message.
 void		ndef_print_info		(ndef_ctx ctx);
 
+// Check that a blob of NDEF data is a well-formed message without allocating any memory.
+// If `info` is not NULL, it is filled in with the sizes of the contents.
+ndef_err	ndef_validate		(const uint8_t *data, size_t len, ndef_validate_info *info);
 // Parse a blob of NDEF data.
 // Sets `len` to the amount of successfully decoded data when finished.
 ndef_ctx	ndef_decode			(uint8_t *data, size_t *len);
+// Parse a blob of NDEF data without copying it.
+// The `type`, `payload` and `id` of the records point into `data`, which must outlive the context.
+// Sets `len` to the amount of successfully decoded data when finished.
+ndef_ctx	ndef_decode_view	(uint8_t *data, size_t *len);
+// Parse a blob of NDEF data into a single allocation owned by the context.
+// Sets `len` to the amount of successfully decoded data when finished.
+ndef_ctx	ndef_decode_arena	(uint8_t *data, size_t *len);
+// Parse a blob of NDEF data, replacing the records in an existing context.
+// Returns true if all of `data` was decoded; `len` is set to the amount of successfully decoded data.
+bool		ndef_decode_into	(ndef_ctx ctx, uint8_t *data, size_t *len);
+// Parse a blob of NDEF data without copying it, replacing the records in an existing context.
+// Returns true if all of `data` was decoded; `len` is set to the amount of successfully decoded data.
+bool		ndef_decode_view_into(ndef_ctx ctx, uint8_t *data, size_t *len);
+// Parse a blob of NDEF data into the context's arena, replacing the records in an existing context.
+// Returns true if all of `data` was decoded; `len` is set to the amount of successfully decoded data.
+bool		ndef_decode_arena_into(ndef_ctx ctx, uint8_t *data, size_t *len);
 // Encode the NDEF data into a new blob.
 bool		ndef_encode			(ndef_ctx ctx, uint8_t **out_data, size_t *out_len);
+// Determine the exact size of the blob `ndef_encode` would produce.
+size_t		ndef_encode_size	(ndef_ctx ctx);
+// Encode the NDEF data into a caller-provided buffer of `cap` bytes without allocating.
+// Fails if the buffer is too small; use `ndef_encode_size` to size it.
+bool		ndef_encode_into	(ndef_ctx ctx, uint8_t *buf, size_t cap, size_t *out_len);
+// Encode the NDEF data, passing it to `write` as it is produced instead of storing it.
+// If `batch` is not NULL, writes are collected into batches of `batch_len` bytes, except for the last one.
+// Use `ndef_encode_size` to determine the total length up front.
+bool		ndef_encode_stream	(ndef_ctx ctx, ndef_write_cb write, void *cookie, uint8_t *batch, size_t batch_len);
+// Encode the NDEF data like `ndef_encode`, but keep the layout of records that have raw records,
+// and find the byte ranges that differ from the baseline: the data last decoded or diffed against.
+// The ranges are widened to pages of `page_size` bytes, where the message starts `page_offset` bytes into a page,
+// and clipped to the message; free `*ranges` with `ndef_free`. The new encoding becomes the baseline.
+// If the length changed, the caller must also update the length in the TLV or NLEN.
+bool		ndef_encode_diff	(ndef_ctx ctx, size_t page_size, size_t page_offset,
+								uint8_t **out_data, size_t *out_len, ndef_range **ranges, size_t *ranges_len);
+// Whether record `index` was inserted or replaced since the last decode or `ndef_encode_diff`.
+bool		ndef_record_is_dirty(ndef_ctx ctx, size_t index);
+
+// Set the maximum payload size of a raw record when encoding.
+// Larger payloads are split into chunked records; 0 (the default) disables chunking.
+void		ndef_set_chunk_size	(ndef_ctx ctx, size_t chunk_size);
+// Get a number that changes every time the records or the chunk size change, and thus the output of `ndef_encode`.
+uint32_t	ndef_get_generation	(ndef_ctx ctx);
+// Get the reason the last decode, encode or insertion on this context failed, or `NDEF_OK`.
+// If not NULL, `offset` is set to where in the data it failed.
+ndef_err	ndef_get_error		(ndef_ctx ctx, size_t *offset);
+
+#ifdef NDEF_ENABLE_LOG
+// Set the function that receives diagnostic messages, or NULL to print them.
+// Not thread-safe; set it before using the library.
+void		ndef_set_log_hook	(ndef_log_cb cb, void *cookie);
+#endif
+
+#ifdef NDEF_ENABLE_STATS
+// Get a snapshot of the phase counters.
+void		ndef_stats_get		(ndef_stats *out);
+// Set all phase counters to zero.
+void		ndef_stats_reset	();
+// Set the functions called when a phase begins and ends; either may be NULL.
+// Not thread-safe; set them before using the library.
+void		ndef_set_phase_hooks(ndef_phase_cb begin, ndef_phase_cb end, void *cookie);
+#endif
 
 // Get the number of raw NDEF records.
 size_t		ndef_raw_records_len(ndef_ctx ctx);
 // Get a pointer to the raw NDEF records.
+// They are reconstructed from the abstract records and remain valid until the context is next modified.
 const ndef_raw_record *
 			ndef_raw_records	(ndef_ctx ctx);
-// Delete all raw records but keep abstract ones.
+// Delete all raw records but keep abstract ones and the allocated memory.
 void		ndef_raw_clear		(ndef_ctx ctx);
 
 // Get the number of abstract NDEF records.
@@ -243,6 +578,8 @@ size_t		ndef_records_len	(ndef_ctx ctx);
 // Get a pointer to the abstract NDEF records.
 const ndef_record *
 			ndef_records		(ndef_ctx ctx);
+// Delete all records but keep the allocated memory for reuse.
+void		ndef_reset			(ndef_ctx ctx);
 // Delete all records.
 void		ndef_clear			(ndef_ctx ctx);
 
@@ -250,6 +587,13 @@ void		ndef_clear			(ndef_ctx ctx);
 void		ndef_splice			(ndef_ctx ctx, size_t index);
 // Delete one or more NDEF records in the message.
 void		ndef_splice_n		(ndef_ctx ctx, size_t index, size_t len);
+// Replace an NDEF record in the message, keeping all others in place.
+// Does not create a corresponding raw record.
+bool		ndef_replace		(ndef_ctx ctx, size_t index, ndef_record record);
+// Replace an NDEF record in the message, keeping all others in place.
+// Does not create a corresponding raw record.
+// Moves the input data; `ctx` shall take ownership of contained resources if and only if the operation is successful.
+bool		ndef_replace_mv		(ndef_ctx ctx, size_t index, ndef_record record);
 
 // Insert an NDEF record in an arbitrary index in the message.
 // Does not create a corresponding raw record.
@@ -281,16 +625,19 @@ bool		ndef_append_mv		(ndef_ctx ctx, ndef_record record);
 // Moves the input data; `ctx` shall take ownership of contained resources if and only if the operation is successful.
 bool		ndef_append_n_mv	(ndef_ctx ctx, size_t index, ndef_record *records, size_t len);
 
+// Make a deep copy of an NDEF record, which owns all of its fields.
+bool		ndef_record_clone	(ndef_record in, ndef_record *out);
+
 
 // Create an ndef_raw_record with all ZERO / NULL.
 static inline ndef_raw_record ndef_raw_record_init() {
 	return (ndef_raw_record) { 0 };
 }
-// Free resources from an ndef_raw_record (call `free` on `type`, `payload` and `id`).
+// Free resources from an ndef_raw_record (call `ndef_free` on `type`, `payload` and `id` unless borrowed).
 static inline void ndef_raw_record_destroy(ndef_raw_record ctx) {
-	if (ctx.type)    free(ctx.type);
-	if (ctx.payload) free(ctx.payload);
-	if (ctx.id)      free(ctx.id);
+	if (ctx.type    && !(ctx.borrowed & NDEF_BORROW_TYPE))    ndef_free(ctx.type,    NDEF_ALLOC_FIELD);
+	if (ctx.payload && !(ctx.borrowed & NDEF_BORROW_PAYLOAD)) ndef_free(ctx.payload, NDEF_ALLOC_PAYLOAD);
+	if (ctx.id      && !(ctx.borrowed & NDEF_BORROW_ID))      ndef_free(ctx.id,      NDEF_ALLOC_FIELD);
 }
 
 
@@ -298,11 +645,11 @@ static inline void ndef_raw_record_destroy(ndef_raw_record ctx) {
 static inline ndef_record ndef_record_init() {
 	return (ndef_record) { 0 };
 }
-// Free resources from an ndef_record (call `free` on `type`, `payload` and `id`).
+// Free resources from an ndef_record (call `ndef_free` on `type`, `payload` and `id` unless borrowed).
 static inline void ndef_record_destroy(ndef_record ctx) {
-	if (ctx.type)    free(ctx.type);
-	if (ctx.payload) free(ctx.payload);
-	if (ctx.id)      free(ctx.id);
+	if (ctx.type    && !(ctx.borrowed & NDEF_BORROW_TYPE))    ndef_free(ctx.type,    NDEF_ALLOC_FIELD);
+	if (ctx.payload && !(ctx.borrowed & NDEF_BORROW_PAYLOAD)) ndef_free(ctx.payload, NDEF_ALLOC_PAYLOAD);
+	if (ctx.id      && !(ctx.borrowed & NDEF_BORROW_ID))      ndef_free(ctx.id,      NDEF_ALLOC_FIELD);
 }
 
 
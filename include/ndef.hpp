@@ -0,0 +1,405 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+
+#include "ndef.h"
+#include "ndef_record_types.h"
+
+#include <iterator>
+#include <optional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if __cplusplus < 201703L
+#error "ndef.hpp requires C++17 or newer"
+#endif
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#define NDEF_HPP_STD_SPAN
+#endif
+
+
+
+// C++ wrapper: move-only owning types over the `_mv` functions, and views over the zero-copy accessors.
+// Deep copies only happen through functions that say so: `clone` and `append_copy`.
+namespace ndef {
+
+#ifdef NDEF_HPP_STD_SPAN
+// Contiguous range of `T`.
+template <typename T>
+using span = std::span<T>;
+#else
+// Contiguous range of `T`; a minimal stand-in for `std::span` before C++20.
+template <typename T>
+class span {
+	public:
+		constexpr span() noexcept : ptr_(nullptr), len_(0) {}
+		constexpr span(T *ptr, size_t len) noexcept : ptr_(ptr), len_(len) {}
+		template <size_t N>
+		constexpr span(T (&arr)[N]) noexcept : ptr_(arr), len_(N) {}
+		template <typename C, typename = decltype(std::declval<C &>().data())>
+		constexpr span(C &cont) noexcept : ptr_(cont.data()), len_(cont.size()) {}
+		
+		constexpr T     *data()  const noexcept { return ptr_; }
+		constexpr size_t size()  const noexcept { return len_; }
+		constexpr bool   empty() const noexcept { return !len_; }
+		constexpr T     *begin() const noexcept { return ptr_; }
+		constexpr T     *end()   const noexcept { return ptr_ + len_; }
+		constexpr T &operator[](size_t i) const noexcept { return ptr_[i]; }
+		
+	private:
+		T     *ptr_;
+		size_t len_;
+};
+#endif
+
+// Read-only bytes of a record field or encoded message.
+using bytes = span<const uint8_t>;
+
+// Matches records of type name format `TNF` and type `Type...` at compile time, e.g. `type_match<NDEF_TNF_WELL_KNOWN, 'U'>`.
+template <ndef_tnf TNF, char... Type>
+struct type_match {
+	static constexpr bool match(const ndef_record &rec) noexcept {
+		if (rec.tnf != TNF || rec.type_len != sizeof...(Type)) return false;
+		size_t i = 0;
+		return ((rec.type[i++] == (uint8_t) Type) && ...);
+	}
+};
+
+// Matches URI records.
+using uri_type         = type_match<NDEF_TNF_WELL_KNOWN, 'U'>;
+// Matches text records.
+using text_type        = type_match<NDEF_TNF_WELL_KNOWN, 'T'>;
+// Matches smart poster records.
+using smartposter_type = type_match<NDEF_TNF_WELL_KNOWN, 'S', 'p'>;
+
+// The parts of a URI record's URI; see `ndef_uri_view`.
+struct uri_parts {
+	// Expanded abbreviation.
+	std::string_view prefix;
+	// Remainder of the URI.
+	std::string_view rest;
+	
+	// Get the full URI.
+	std::string str() const {
+		std::string out;
+		out.reserve(prefix.size() + rest.size());
+		out.append(prefix).append(rest);
+		return out;
+	}
+};
+
+// The language and text of a text record; see `ndef_text_view`.
+struct text_parts {
+	// ISO/IANA language code.
+	std::string_view lang;
+	// Text data, UTF-8 or UTF-16 depending on `is_utf16`.
+	bytes            text;
+	// Whether the text is encoded as UTF-16 instead of UTF-8.
+	bool             is_utf16;
+	
+	// Get the text as UTF-8, converting it from UTF-16 if needed.
+	std::string utf8() const {
+		if (!is_utf16) return std::string((const char *) text.data(), text.size());
+		std::string out(ndef_utf16_to_utf8(text.data(), text.size(), nullptr, 0), '\0');
+		ndef_utf16_to_utf8(text.data(), text.size(), out.data(), out.size() + 1);
+		return out;
+	}
+};
+
+class record;
+
+// Non-owning view of a record: the record it refers to must outlive it.
+class record_view {
+	public:
+		constexpr record_view(const ndef_record &rec) noexcept : rec_(&rec) {}
+		
+		// Get the type name format.
+		ndef_tnf_t       tnf()      const noexcept { return rec_->tnf; }
+		// Get the type field.
+		bytes            type()     const noexcept { return bytes(rec_->type, rec_->type_len); }
+		// Get the type field as characters.
+		std::string_view type_str() const noexcept { return std::string_view((const char *) rec_->type, rec_->type_len); }
+		// Get the ID field.
+		bytes            id()       const noexcept { return bytes(rec_->id, rec_->id_len); }
+		// Get the payload.
+		bytes            payload()  const noexcept { return bytes(rec_->payload, rec_->payload_len); }
+		// Get the kind of record (`ndef_kind`), classifying it if that has not been done yet.
+		uint8_t          kind()     const noexcept { return ndef_record_kind(*rec_); }
+		// Get the underlying record.
+		const ndef_record &get()    const noexcept { return *rec_; }
+		
+		// Whether the record matches `Match`, e.g. `is<ndef::uri_type>()`.
+		template <typename Match>
+		constexpr bool is() const noexcept { return Match::match(*rec_); }
+		
+		// Get the URI of a URI record without copying.
+		std::optional<uri_parts> uri() const noexcept {
+			ndef_uri_view view;
+			if (!ndef_record_get_uri_view(*rec_, &view)) return std::nullopt;
+			return uri_parts { { view.prefix, view.prefix_len }, { view.rest, view.rest_len } };
+		}
+		// Get the language and text of a text record without copying.
+		std::optional<text_parts> text() const noexcept {
+			ndef_text_view view;
+			if (!ndef_record_get_text_view(*rec_, &view)) return std::nullopt;
+			return text_parts { { view.lang, view.lang_len }, bytes(view.text, view.text_len), view.is_utf16 };
+		}
+		// Find the first URI and text in a smart poster record without copying.
+		std::optional<ndef_smartposter_view> smartposter() const noexcept {
+			ndef_smartposter_view view;
+			if (!ndef_record_get_smartposter_view(*rec_, &view)) return std::nullopt;
+			return view;
+		}
+		
+		// Make a deep copy of the record.
+		inline record clone() const;
+		
+	private:
+		const ndef_record *rec_;
+};
+
+// Owning record, which frees its fields unless they are borrowed.
+class record {
+	public:
+		record() noexcept : rec_(ndef_record_init()) {}
+		// Take ownership of `rec`.
+		explicit record(ndef_record rec) noexcept : rec_(rec) {}
+		record(const record &) = delete;
+		record &operator=(const record &) = delete;
+		record(record &&other) noexcept : rec_(other.release()) {}
+		record &operator=(record &&other) noexcept {
+			if (this != &other) {
+				ndef_record_destroy(rec_);
+				rec_ = other.release();
+			}
+			return *this;
+		}
+		~record() { ndef_record_destroy(rec_); }
+		
+		// Make a URI record, abbreviated according to `ndef_uri_abbrev`.
+		static record uri(const char *uri) { return record(ndef_record_new_uri(uri)); }
+		// Make a URI record without abbreviation.
+		static record raw_uri(const char *uri) { return record(ndef_record_new_raw_uri(uri)); }
+		// Make a UTF-8 text record.
+		static record text(const char *lang, const char *text) {
+			return record(ndef_record_new_text(ndef_text { const_cast<char *>(lang), const_cast<char *>(text) }));
+		}
+		// Make a smart poster record; `uri`, `lang` and `text` are optional, but there must be a URI or a text.
+		static record smartposter(const char *uri, const char *lang, const char *text) {
+			ndef_smartposter sp = ndef_smartposter_init();
+			sp.uri  = const_cast<char *>(uri);
+			sp.text = ndef_text { const_cast<char *>(lang), const_cast<char *>(text) };
+			return record(ndef_record_new_smartposter(sp));
+		}
+		
+		// Whether the record has any content; the constructors return empty records when out of memory.
+		explicit operator bool() const noexcept {
+			return rec_.tnf != NDEF_TNF_EMPTY || rec_.type_len || rec_.payload_len || rec_.id_len;
+		}
+		// Get a view of the record.
+		record_view view() const noexcept { return record_view(rec_); }
+		// Get the underlying record.
+		const ndef_record &get() const noexcept { return rec_; }
+		// Give up ownership of the underlying record, leaving this one empty.
+		ndef_record release() noexcept {
+			ndef_record out = rec_;
+			rec_ = ndef_record_init();
+			return out;
+		}
+		
+	private:
+		ndef_record rec_;
+};
+
+// Make a deep copy of the record.
+inline record record_view::clone() const {
+	ndef_record out;
+	if (!ndef_record_clone(*rec_, &out)) return record();
+	return record(out);
+}
+
+// Random-access iterator over the records of a message, as views.
+class record_iterator {
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type        = record_view;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = void;
+		using reference         = record_view;
+		
+		constexpr record_iterator() noexcept : ptr_(nullptr) {}
+		constexpr explicit record_iterator(const ndef_record *ptr) noexcept : ptr_(ptr) {}
+		
+		record_view operator*() const noexcept { return record_view(*ptr_); }
+		record_view operator[](difference_type i) const noexcept { return record_view(ptr_[i]); }
+		
+		record_iterator &operator++() noexcept { ptr_++; return *this; }
+		record_iterator &operator--() noexcept { ptr_--; return *this; }
+		record_iterator  operator++(int) noexcept { return record_iterator(ptr_++); }
+		record_iterator  operator--(int) noexcept { return record_iterator(ptr_--); }
+		record_iterator &operator+=(difference_type n) noexcept { ptr_ += n; return *this; }
+		record_iterator &operator-=(difference_type n) noexcept { ptr_ -= n; return *this; }
+		record_iterator  operator+(difference_type n) const noexcept { return record_iterator(ptr_ + n); }
+		record_iterator  operator-(difference_type n) const noexcept { return record_iterator(ptr_ - n); }
+		difference_type  operator-(record_iterator other) const noexcept { return ptr_ - other.ptr_; }
+		friend record_iterator operator+(difference_type n, record_iterator it) noexcept { return it + n; }
+		
+		bool operator==(record_iterator other) const noexcept { return ptr_ == other.ptr_; }
+		bool operator!=(record_iterator other) const noexcept { return ptr_ != other.ptr_; }
+		bool operator< (record_iterator other) const noexcept { return ptr_ <  other.ptr_; }
+		bool operator> (record_iterator other) const noexcept { return ptr_ >  other.ptr_; }
+		bool operator<=(record_iterator other) const noexcept { return ptr_ <= other.ptr_; }
+		bool operator>=(record_iterator other) const noexcept { return ptr_ >= other.ptr_; }
+		
+	private:
+		const ndef_record *ptr_;
+};
+
+// Owning NDEF message context.
+// A message that failed to be created is null, which is what `operator bool` checks; other methods require a valid one.
+class message {
+	public:
+		// Create an empty message.
+		message() noexcept : ctx_(ndef_init()) {}
+		// Take ownership of `ctx`.
+		explicit message(ndef_ctx ctx) noexcept : ctx_(ctx) {}
+		message(const message &) = delete;
+		message &operator=(const message &) = delete;
+		message(message &&other) noexcept : ctx_(other.release()) {}
+		message &operator=(message &&other) noexcept {
+			if (this != &other) {
+				if (ctx_) ndef_destroy(ctx_);
+				ctx_ = other.release();
+			}
+			return *this;
+		}
+		~message() { if (ctx_) ndef_destroy(ctx_); }
+		
+		// Decode a message, copying every field; the decoder does not write to `data`.
+		static message decode(bytes data) {
+			size_t len = data.size();
+			return message(ndef_decode(const_cast<uint8_t *>(data.data()), &len));
+		}
+		// Decode a message without copying; `data` must outlive the message.
+		static message decode_view(bytes data) {
+			size_t len = data.size();
+			return message(ndef_decode_view(const_cast<uint8_t *>(data.data()), &len));
+		}
+		// Decode a message, copying the fields into a single arena.
+		static message decode_arena(bytes data) {
+			size_t len = data.size();
+			return message(ndef_decode_arena(const_cast<uint8_t *>(data.data()), &len));
+		}
+		// Decode the inner message of a smart poster view without copying; its record must outlive the message.
+		static message decode_smartposter(const ndef_smartposter_view &view) {
+			return message(ndef_smartposter_view_decode(&view));
+		}
+		
+		// Replace the records with those decoded from `data` without copying; `data` must outlive the records.
+		bool decode_view_into(bytes data) {
+			size_t len = data.size();
+			return ndef_decode_view_into(ctx_, const_cast<uint8_t *>(data.data()), &len);
+		}
+		// Replace the records with those decoded from `data`, copying the fields into the arena.
+		bool decode_arena_into(bytes data) {
+			size_t len = data.size();
+			return ndef_decode_arena_into(ctx_, const_cast<uint8_t *>(data.data()), &len);
+		}
+		
+		// Whether the message exists.
+		explicit operator bool() const noexcept { return ctx_ != nullptr; }
+		// Get the number of records.
+		size_t          size()  const { return ndef_records_len(ctx_); }
+		// Whether there are no records.
+		bool            empty() const { return !size(); }
+		// Get a view of record `index`, which must exist.
+		record_view     operator[](size_t index) const { return record_view(ndef_records(ctx_)[index]); }
+		// Get the records as a contiguous range.
+		span<const ndef_record> records() const { return span<const ndef_record>(ndef_records(ctx_), size()); }
+		record_iterator begin() const { return record_iterator(ndef_records(ctx_)); }
+		record_iterator end()   const { return record_iterator(ndef_records(ctx_) + size()); }
+		
+		// Append a record, taking ownership of it if successful.
+		bool append(record &&rec) {
+			if (!ndef_append_mv(ctx_, rec.get())) return false;
+			rec.release();
+			return true;
+		}
+		// Insert a record at `index`, taking ownership of it if successful.
+		bool insert(size_t index, record &&rec) {
+			if (!ndef_insert_mv(ctx_, index, rec.get())) return false;
+			rec.release();
+			return true;
+		}
+		// Replace record `index`, taking ownership of the new record if successful.
+		bool replace(size_t index, record &&rec) {
+			if (!ndef_replace_mv(ctx_, index, rec.get())) return false;
+			rec.release();
+			return true;
+		}
+		// Append a deep copy of a record.
+		bool append_copy(record_view rec) { return ndef_append(ctx_, rec.get()); }
+		// Delete `len` records starting at `index`.
+		void erase(size_t index, size_t len = 1) { ndef_splice_n(ctx_, index, len); }
+		// Delete all records.
+		void clear() { ndef_clear(ctx_); }
+		
+		// Get the exact length of the encoded message.
+		size_t encode_size() const { return ndef_encode_size(ctx_); }
+		// Encode into `buf`, setting `len` to the encoded length.
+		bool encode_into(span<uint8_t> buf, size_t &len) { return ndef_encode_into(ctx_, buf.data(), buf.size(), &len); }
+		// Encode into a new vector, which is empty on error.
+		std::vector<uint8_t> encode() {
+			std::vector<uint8_t> out(encode_size());
+			size_t len = 0;
+			if (!ndef_encode_into(ctx_, out.data(), out.size(), &len)) return {};
+			out.resize(len);
+			return out;
+		}
+		
+		// Make a clone that shares the record data; see `ndef_clone`.
+		// This modifies the message: ownership of its record data moves to a pool shared with the clone.
+		message clone() { return message(ndef_clone(ctx_)); }
+		// Get the reason the last operation failed, or `NDEF_OK`.
+		ndef_err error() const { return ndef_get_error(ctx_, nullptr); }
+		// Get the underlying context.
+		ndef_ctx get() const noexcept { return ctx_; }
+		// Give up ownership of the underlying context, leaving this message null.
+		ndef_ctx release() noexcept {
+			ndef_ctx out = ctx_;
+			ctx_ = nullptr;
+			return out;
+		}
+		
+	private:
+		ndef_ctx ctx_;
+};
+
+} // namespace ndef
@@ -0,0 +1,98 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// What an allocation is used for, so an allocator can decide where to place it.
+typedef enum {
+	// Contexts, record arrays and other bookkeeping.
+	NDEF_ALLOC_ARRAY,
+	// Type and ID fields and other small strings.
+	NDEF_ALLOC_FIELD,
+	// Record payloads.
+	NDEF_ALLOC_PAYLOAD,
+	// The arena of a context that decodes with `ndef_decode_arena`.
+	NDEF_ALLOC_ARENA,
+	// Encoded messages and strings handed to the caller.
+	NDEF_ALLOC_OUTPUT,
+} ndef_alloc_kind;
+
+// A set of allocation functions.
+// They behave like `malloc`, `realloc` and `free`; `realloc` with a NULL pointer must allocate.
+typedef struct {
+	// Allocate `size` bytes.
+	void *(*alloc)(void *cookie, size_t size, ndef_alloc_kind kind);
+	// Resize an allocation made with the same kind.
+	void *(*realloc)(void *cookie, void *ptr, size_t size, ndef_alloc_kind kind);
+	// Free an allocation made with the same kind.
+	void  (*free)(void *cookie, void *ptr, ndef_alloc_kind kind);
+	// Cookie passed to the functions.
+	void   *cookie;
+} ndef_allocator;
+
+// Allocator that uses `malloc`, `realloc` and `free`.
+extern const ndef_allocator ndef_default_allocator;
+
+// Set the allocator used for records and for memory handed to the caller, or NULL for the default.
+// It must outlive everything allocated with it. Not thread-safe; set it before using the library.
+void ndef_set_allocator(const ndef_allocator *alloc);
+// Get the allocator used for records and for memory handed to the caller.
+const ndef_allocator *ndef_get_allocator();
+
+// Allocate memory with the global allocator.
+void *ndef_malloc(size_t size, ndef_alloc_kind kind);
+// Resize memory allocated with `ndef_malloc`.
+void *ndef_realloc(void *ptr, size_t size, ndef_alloc_kind kind);
+// Free memory allocated by the library, such as encoded messages and extracted strings.
+// Equivalent to `free` unless a different allocator was set.
+void ndef_free(void *ptr, ndef_alloc_kind kind);
+
+#ifdef ESP_PLATFORM
+// Placement of memory for `ndef_heap_caps_allocator`, as `MALLOC_CAP_*` masks.
+typedef struct {
+	// Capabilities for bookkeeping, fields and small data, e.g. `MALLOC_CAP_INTERNAL`.
+	uint32_t small_caps;
+	// Capabilities for payloads, arenas and output of at least `large_threshold` bytes, e.g. `MALLOC_CAP_SPIRAM`.
+	uint32_t large_caps;
+	// Size in bytes from which data counts as large.
+	size_t   large_threshold;
+} ndef_heap_caps_config;
+
+// Make an allocator that places memory with `heap_caps_malloc`, falling back to any 8-bit capable memory.
+// `config` must outlive the allocator.
+ndef_allocator ndef_heap_caps_allocator(const ndef_heap_caps_config *config);
+#endif
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,69 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "ndef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Ways in which a batch of NDEF data can be decoded.
+typedef enum {
+	// Like `ndef_decode`: every field is copied into its own allocation.
+	NDEF_DECODE_COPY,
+	// Like `ndef_decode_view`: fields point into the input data.
+	NDEF_DECODE_VIEW,
+	// Like `ndef_decode_arena`: fields are copied into the context's arena.
+	NDEF_DECODE_ARENA,
+} ndef_decode_mode;
+
+// Called by a worker for every decoded message of a batch.
+// `ok` is false if the message could not be decoded completely.
+// `ctx` belongs to the worker and is reused for its next message after this returns.
+// Different workers may call this at the same time.
+typedef void (*ndef_batch_cb)(void *cookie, size_t index, ndef_ctx ctx, bool ok);
+
+// Stack size in bytes of batch worker tasks on FreeRTOS.
+#ifndef NDEF_BATCH_STACK_SIZE
+#define NDEF_BATCH_STACK_SIZE 4096
+#endif
+
+// Decode `count` blobs of NDEF data, spread over up to `workers` threads (0 for one per core).
+// Every worker decodes into a single reused context, which is passed to `cb` for each message.
+// Record types must be registered before starting a batch.
+// Returns false if any of the messages could not be decoded completely.
+bool ndef_decode_batch(uint8_t *const *data, const size_t *len, size_t count, ndef_decode_mode mode, ndef_batch_cb cb, void *cookie, size_t workers);
+// Encode `count` contexts, spread over up to `workers` threads (0 for one per core).
+// Every context may only appear once; the results are stored in `out_data` and `out_len` like `ndef_encode`.
+// Returns false if any of the messages could not be encoded, in which case its `out_data` is NULL.
+bool ndef_encode_batch(const ndef_ctx *ctx, size_t count, uint8_t **out_data, size_t *out_len, size_t workers);
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,57 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+
+#include "ndef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Size of the buffer `ndef_print_info` renders into before writing it out.
+#ifndef NDEF_PRINT_BUF_SIZE
+#define NDEF_PRINT_BUF_SIZE 256
+#endif
+
+// Output formats of `ndef_format_info`.
+typedef enum {
+	// Indented human-readable text, as printed by `ndef_print_info`.
+	NDEF_FORMAT_TEXT,
+	// Compact JSON on one line.
+	NDEF_FORMAT_JSON,
+} ndef_format;
+
+// Render hierarchical info about an NDEF message into `buf`, which is NUL-terminated if `cap` is nonzero.
+// Returns the length of the full output even if it was truncated, like `snprintf`.
+size_t ndef_format_info(ndef_ctx ctx, char *buf, size_t cap, ndef_format format);
+// Render hierarchical info about an NDEF record into `buf`, which is NUL-terminated if `cap` is nonzero.
+// Returns the length of the full output even if it was truncated, like `snprintf`.
+size_t ndef_record_format_info(ndef_record record, char *buf, size_t cap, ndef_format format);
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,123 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+
+#include "ndef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Payloads up to this many bytes are copied into the image; longer ones are served from the records in place.
+#ifndef NDEF_IMAGE_INLINE_MAX
+#define NDEF_IMAGE_INLINE_MAX 32
+#endif
+
+// Framing around the NDEF message in an encoded image.
+typedef enum {
+	// Just the NDEF message.
+	NDEF_IMAGE_RAW,
+	// Type 2 NDEF TLV followed by a terminator TLV, as stored from page 4 on.
+	NDEF_IMAGE_T2_TLV,
+	// Type 4 NDEF file: 2-byte NLEN followed by the message.
+	NDEF_IMAGE_T4_NLEN,
+	// Type 4 extended NDEF file: 4-byte ENLEN followed by the message.
+	NDEF_IMAGE_T4_ENLEN,
+} ndef_image_format;
+
+#ifdef NDEF_REVEAL_PRIVATE
+
+// A contiguous part of an encoded image.
+typedef struct {
+	// Offset of the segment in the image.
+	size_t         offset;
+	// Length of the segment.
+	size_t         len;
+	// Data of the segment, in the image's inline data or in record data.
+	const uint8_t *data;
+} ndef_image_seg;
+
+// Encoded image of the records in a context, for reads at arbitrary offsets.
+typedef struct {
+	// Context the image is of.
+	ndef_ctx          ctx;
+	// Framing around the message.
+	ndef_image_format format;
+	// Generation of `ctx` the segments were built for.
+	uint32_t          generation;
+	// Whether the segments are built.
+	bool              valid;
+	// Reason the last operation failed.
+	ndef_err          error;
+	
+	// Total length of the image.
+	size_t            len;
+	// Number of segments.
+	size_t            segs_len;
+	// Capacity for segments.
+	size_t            segs_cap;
+	// Segments in order of their offset.
+	ndef_image_seg   *segs;
+	// Segment the last read ended in.
+	size_t            cursor;
+	
+	// Number of bytes of headers, short fields and framing.
+	size_t            inline_len;
+	// Capacity for inline data.
+	size_t            inline_cap;
+	// Headers, short fields and framing.
+	uint8_t          *inline_data;
+} ndef_image_s;
+
+// Encoded image of the records in a context, for reads at arbitrary offsets.
+typedef ndef_image_s *ndef_image;
+
+#else
+
+// Encoded image of the records in a context, for reads at arbitrary offsets.
+typedef void *ndef_image;
+
+#endif
+
+// Create an encoded image of the records in `ctx`, which must outlive it.
+// The image is rebuilt on the next read after the records change; payloads are not copied.
+ndef_image	ndef_image_init		(ndef_ctx ctx, ndef_image_format format);
+// Destroy an encoded image.
+void		ndef_image_destroy	(ndef_image img);
+// Rebuild the image if the records changed since it was last built.
+bool		ndef_image_update	(ndef_image img);
+// Get the length of the image, including framing, or 0 if it cannot be built.
+size_t		ndef_image_len		(ndef_image img);
+// Copy up to `len` bytes of the image at `offset` into `buf`, rebuilding it first if needed.
+// Returns the number of bytes copied, which is less than `len` at the end of the image or on error.
+size_t		ndef_image_read_at	(ndef_image img, size_t offset, uint8_t *buf, size_t len);
+// Get the reason the last operation on the image failed, or `NDEF_OK`.
+ndef_err	ndef_image_get_error(ndef_image img);
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,118 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "ndef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Returned by index lookups when there is no matching record.
+#define NDEF_INDEX_NONE SIZE_MAX
+
+// Location and size of one abstract record in indexed NDEF data.
+typedef struct {
+	// Offset of the first raw record in the data.
+	size_t       offset;
+	// Encoded length of all raw records of this record.
+	size_t       len;
+	// Offset of the payload in the data, or 0 if it is split over multiple chunks.
+	size_t       payload_offset;
+	// Total length of the payload.
+	ndef_len_t   payload_len;
+	// Number of raw records used to make this record.
+	ndef_index_t raw_len;
+	// Next record in the same type hash bucket.
+	ndef_index_t type_next;
+	// Next record in the same ID hash bucket.
+	ndef_index_t id_next;
+	// Type of data in this record.
+	ndef_tnf_t   tnf;
+	// Length of the type field.
+	uint8_t      type_len;
+	// Length of the ID field.
+	uint8_t      id_len;
+} ndef_index_entry;
+
+#ifdef NDEF_REVEAL_PRIVATE
+
+// Random-access index of the records in a blob of NDEF data.
+typedef struct {
+	// Indexed data.
+	uint8_t          *data;
+	// Number of records.
+	size_t            records_len;
+	// Location of every record.
+	ndef_index_entry *records;
+	// Number of hash buckets.
+	size_t            buckets_len;
+	// First record in each type hash bucket.
+	ndef_index_t     *type_buckets;
+	// First record in each ID hash bucket.
+	ndef_index_t     *id_buckets;
+} ndef_index_s;
+
+// Random-access index of the records in a blob of NDEF data.
+typedef ndef_index_s *ndef_index;
+
+#else
+
+// Random-access index of the records in a blob of NDEF data.
+typedef void *ndef_index;
+
+#endif
+
+// Index the records in a blob of NDEF data, which must outlive the index.
+// Only reads the record headers; returns NULL if the data is not a valid message or out of memory.
+ndef_index	ndef_index_build	(uint8_t *data, size_t len);
+// Destroy an index.
+void		ndef_index_destroy	(ndef_index idx);
+// Get the number of records in the index.
+size_t		ndef_index_len		(ndef_index idx);
+// Get the location and size of record `n`, or NULL if out of range.
+const ndef_index_entry *
+			ndef_index_entry_get(ndef_index idx, size_t n);
+// Get a view of record `n` without decoding the rest of the message.
+// The fields point into the indexed data. If the payload is split over multiple chunks, `payload` is NULL,
+// `payload_len` is 0 and the kind is `NDEF_KIND_OTHER`; use `ndef_index_read_payload` to join it.
+// Returns false if `n` is out of range.
+bool		ndef_index_get		(ndef_index idx, size_t n, ndef_record *out);
+// Copy the payload of record `n` into `buf`, joining chunks if needed.
+// Returns the payload length, which is copied only if `cap` is large enough.
+size_t		ndef_index_read_payload(ndef_index idx, size_t n, uint8_t *buf, size_t cap);
+// Find the first record at or after `start` with the given TNF and type.
+// Returns `NDEF_INDEX_NONE` if there is none.
+size_t		ndef_index_find_type(ndef_index idx, ndef_tnf tnf, const uint8_t *type, size_t type_len, size_t start);
+// Find the first record at or after `start` with the given ID.
+// Returns `NDEF_INDEX_NONE` if there is none.
+size_t		ndef_index_find_id	(ndef_index idx, const uint8_t *id, size_t id_len, size_t start);
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -27,3 +27,62 @@
 #include "ndef_uri.h"
 #include "ndef_text.h"
 #include "ndef_smartposter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Kinds of record known to the type registry.
+typedef enum {
+	// Record has not been classified yet.
+	NDEF_KIND_UNCLASSIFIED = 0,
+	// Record is not of any registered type.
+	NDEF_KIND_OTHER,
+	// URI record; well-known type "U".
+	NDEF_KIND_URI,
+	// Text record; well-known type "T".
+	NDEF_KIND_TEXT,
+	// Smart poster record; well-known type "Sp".
+	NDEF_KIND_SMARTPOSTER,
+	// First kind available for `ndef_register_type`.
+	NDEF_KIND_USER,
+} ndef_kind;
+
+// Maximum number of kinds, including the built-in ones.
+#ifndef NDEF_KIND_MAX
+#define NDEF_KIND_MAX 16
+#endif
+
+// Describes a record type for the type registry.
+typedef struct {
+	// Type name format to match.
+	ndef_tnf       tnf;
+	// Length of the type to match.
+	uint8_t        type_len;
+	// Type to match.
+	const uint8_t *type;
+	// Minimum payload length for a record to be of this kind.
+	size_t         min_payload_len;
+	// Human-readable name of this kind.
+	const char    *name;
+} ndef_type_handler;
+
+// Register a record type with the type registry.
+// `handler` must remain valid forever. Not thread-safe; register types before decoding.
+// Returns the kind for the type, or `NDEF_KIND_OTHER` if the registry is full.
+uint8_t ndef_register_type(const ndef_type_handler *handler);
+// Get the registered handler for a kind, or NULL if there is none.
+const ndef_type_handler *ndef_kind_handler(uint8_t kind);
+// Look up the kind of an NDEF record in the type registry.
+uint8_t ndef_classify(ndef_record ctx);
+
+// Get the kind of an NDEF record, classifying it if that has not been done yet.
+static inline uint8_t ndef_record_kind(ndef_record ctx) {
+	return ctx.kind ? ctx.kind : ndef_classify(ctx);
+}
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -25,6 +25,7 @@
 #pragma once
 
 #include "ndef.h"
+#include "ndef_uri.h"
 #include "ndef_text.h"
 
 #ifdef __cplusplus
@@ -42,8 +43,36 @@ typedef struct {
 	ndef_text text;
 } ndef_smartposter;
 
+// The first URI and text found in a smart poster record, pointing into the record.
+typedef struct {
+	// Inner NDEF message, still encoded.
+	uint8_t       *data;
+	// Length of the inner NDEF message.
+	size_t         data_len;
+	
+	// Whether a URI record was found.
+	bool           has_uri;
+	// First found URI record.
+	ndef_record    uri_record;
+	// URI of the first found URI record.
+	ndef_uri_view  uri;
+	
+	// Whether a text record was found.
+	bool           has_text;
+	// First found text record.
+	ndef_record    text_record;
+	// Language and text of the first found text record.
+	ndef_text_view text;
+} ndef_smartposter_view;
+
 // Determine whether an NDEF record is a text record.
 bool ndef_record_is_smartposter(ndef_record ctx);
+// Find the first URI and text records in a smart poster record without decoding or copying it.
+// Returns false when not a smart poster record.
+bool ndef_record_get_smartposter_view(ndef_record ctx, ndef_smartposter_view *out);
+// Decode the inner NDEF message of a smart poster view.
+// The records borrow their data from the smart poster record, which must outlive the context.
+ndef_ctx ndef_smartposter_view_decode(const ndef_smartposter_view *view);
 // Construct a `ndef_smartposter` containing a summary containing the payload NDEF, URI (if present) and text (if present).
 // Returns NULL when out of memory, or when not a smart poster record.
 ndef_smartposter ndef_record_get_smartposter(ndef_record ctx);
@@ -61,7 +90,7 @@ static inline ndef_smartposter ndef_smartposter_init() {
 // Calls `free` on `lang` and `text` in an `ndef_text` struct.
 static inline void ndef_smartposter_destroy(ndef_smartposter ctx) {
 	if (ctx.ndef) ndef_destroy(ctx.ndef);
-	if (ctx.uri) free(ctx.uri);
+	if (ctx.uri) ndef_free(ctx.uri, NDEF_ALLOC_OUTPUT);
 	ndef_text_destroy(ctx.text);
 }
 
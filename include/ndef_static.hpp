@@ -0,0 +1,229 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+
+#include "ndef.h"
+#include "ndef_uri.h"
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+#if __cplusplus < 201703L
+#error "ndef_static.hpp requires C++17 or newer"
+#endif
+
+
+
+// Compile-time builders for NDEF messages that never change, such as the message of an emulated tag.
+// The result is encoded exactly like `ndef_encode` would encode the same records and can live in flash:
+//
+//	NDEF_STATIC_MESSAGE(pairing_msg,
+//		ndef_static::uri("https://example.com/pair"),
+//		ndef_static::text("en", "Hold to pair")
+//	);
+//
+// Which declares `static constexpr std::array<uint8_t, N> pairing_msg`, where N is the exact encoded length.
+namespace ndef_static {
+
+// A record whose type, ID and payload fit in `Cap` bytes.
+template <size_t Cap>
+struct record {
+	// Type name format.
+	ndef_tnf_t              tnf;
+	// Length of the type, which is stored at the start of `data`.
+	size_t                  type_len;
+	// Length of the ID, which is stored after the payload.
+	size_t                  id_len;
+	// Length of the payload, which is stored after the type.
+	size_t                  payload_len;
+	// Type, payload and ID.
+	std::array<uint8_t, Cap> data;
+};
+
+// An encoded message of at most `Cap` bytes; use `NDEF_STATIC_MESSAGE` to get an exactly sized array.
+template <size_t Cap>
+struct message_buf {
+	// Length of the encoded message.
+	size_t                  len;
+	// Encoded message.
+	std::array<uint8_t, Cap> data;
+};
+
+namespace detail {
+
+// Strings of the URI abbreviations in order of their `ndef_uri_abbrev` value.
+#define NDEF_STATIC_ABBREV_STR(str) str,
+constexpr const char *uri_abbrevs[NDEF_URI_ABBREVMAX] = {
+	NDEF_URI_ABBREVS(NDEF_STATIC_ABBREV_STR)
+};
+#undef NDEF_STATIC_ABBREV_STR
+
+// Copy `len` bytes of a string or byte array into `out` at `pos`.
+template <typename T, typename U>
+constexpr void copy(T &out, size_t pos, const U *in, size_t len) {
+	for (size_t i = 0; i < len; i++) out[pos + i] = (uint8_t) in[i];
+}
+
+// Find the length of the abbreviation `ndef_record_new_uri` would use for `uri`.
+constexpr size_t uri_match(const char *uri, size_t uri_len, uint8_t *abbrev) {
+	size_t match_len = 0;
+	*abbrev = 0;
+	for (uint8_t i = 1; i < NDEF_URI_ABBREVMAX; i++) {
+		size_t len = 0;
+		while (uri_abbrevs[i][len]) len++;
+		if (len <= match_len || len > uri_len) continue;
+		bool match = true;
+		for (size_t x = 0; x < len && match; x++) match = uri[x] == uri_abbrevs[i][x];
+		if (match) {
+			*abbrev   = i;
+			match_len = len;
+		}
+	}
+	return match_len;
+}
+
+// Make a URI record with abbreviation `abbrev` followed by `len` bytes of `uri`.
+template <size_t Cap>
+constexpr record<Cap> make_uri(uint8_t abbrev, const char *uri, size_t len) {
+	record<Cap> out{ NDEF_TNF_WELL_KNOWN, 1, 0, 1 + len, {} };
+	out.data[0] = 'U';
+	out.data[1] = abbrev;
+	copy(out.data, 2, uri, len);
+	return out;
+}
+
+// Encode one record into `out` at `pos`, returning the position after it.
+template <size_t OutCap, size_t Cap>
+constexpr size_t put(std::array<uint8_t, OutCap> &out, size_t pos, const record<Cap> &rec, bool begin, bool end) {
+	bool    sr    = rec.payload_len <= 0xff;
+	uint8_t flags = rec.tnf & NDEF_FLAG_TNF;
+	if (begin)      flags |= NDEF_FLAG_MB;
+	if (end)        flags |= NDEF_FLAG_ME;
+	if (sr)         flags |= NDEF_FLAG_SR;
+	if (rec.id_len) flags |= NDEF_FLAG_IL;
+	
+	out[pos++] = flags;
+	out[pos++] = (uint8_t) rec.type_len;
+	if (sr) {
+		out[pos++] = (uint8_t) rec.payload_len;
+	} else {
+		out[pos++] = (uint8_t) (rec.payload_len >> 24);
+		out[pos++] = (uint8_t) (rec.payload_len >> 16);
+		out[pos++] = (uint8_t) (rec.payload_len >> 8);
+		out[pos++] = (uint8_t) rec.payload_len;
+	}
+	if (rec.id_len) out[pos++] = (uint8_t) rec.id_len;
+	
+	// Type, payload and ID are stored in the same order as `ndef_encode` writes them.
+	size_t len = rec.type_len + rec.id_len + rec.payload_len;
+	for (size_t i = 0; i < len; i++) out[pos++] = rec.data[i];
+	return pos;
+}
+
+} // namespace detail
+
+// Make a record from a type and payload given as string literals; the payload excludes the NUL terminator.
+template <size_t TypeLen, size_t PayloadLen>
+constexpr record<TypeLen - 1 + PayloadLen - 1> raw(ndef_tnf_t tnf, const char (&type)[TypeLen], const char (&payload)[PayloadLen]) {
+	static_assert(TypeLen - 1 <= 0xff, "NDEF record type is too long");
+	record<TypeLen - 1 + PayloadLen - 1> out{ tnf, TypeLen - 1, 0, PayloadLen - 1, {} };
+	detail::copy(out.data, 0, type, TypeLen - 1);
+	detail::copy(out.data, TypeLen - 1, payload, PayloadLen - 1);
+	return out;
+}
+
+// Make a record from a type given as string literal and a binary payload.
+template <size_t TypeLen, size_t PayloadLen>
+constexpr record<TypeLen - 1 + PayloadLen> raw(ndef_tnf_t tnf, const char (&type)[TypeLen], const std::array<uint8_t, PayloadLen> &payload) {
+	static_assert(TypeLen - 1 <= 0xff, "NDEF record type is too long");
+	record<TypeLen - 1 + PayloadLen> out{ tnf, TypeLen - 1, 0, PayloadLen, {} };
+	detail::copy(out.data, 0, type, TypeLen - 1);
+	detail::copy(out.data, TypeLen - 1, payload.data(), PayloadLen);
+	return out;
+}
+
+// Make a copy of a record with its ID set to a string literal.
+template <size_t IdLen, size_t Cap>
+constexpr record<Cap + IdLen - 1> with_id(const record<Cap> &rec, const char (&id)[IdLen]) {
+	static_assert(IdLen - 1 <= 0xff, "NDEF record ID is too long");
+	record<Cap + IdLen - 1> out{ rec.tnf, rec.type_len, IdLen - 1, rec.payload_len, {} };
+	detail::copy(out.data, 0, rec.data.data(), rec.type_len + rec.payload_len);
+	detail::copy(out.data, rec.type_len + rec.payload_len, id, IdLen - 1);
+	return out;
+}
+
+// Make a URI record, abbreviated the same way as `ndef_record_new_uri` does.
+template <size_t Len>
+constexpr record<1 + Len> uri(const char (&uri)[Len]) {
+	uint8_t abbrev    = 0;
+	size_t  match_len = detail::uri_match(uri, Len - 1, &abbrev);
+	return detail::make_uri<1 + Len>(abbrev, uri + match_len, Len - 1 - match_len);
+}
+
+// Make a URI record without abbreviation, like `ndef_record_new_raw_uri` does.
+template <size_t Len>
+constexpr record<1 + Len> raw_uri(const char (&uri)[Len]) {
+	return detail::make_uri<1 + Len>(0, uri, Len - 1);
+}
+
+// Make a UTF-8 text record, like `ndef_record_new_text` does.
+template <size_t LangLen, size_t Len>
+constexpr record<LangLen + Len> text(const char (&lang)[LangLen], const char (&text)[Len]) {
+	static_assert(LangLen - 1 >= 2 && LangLen - 1 <= 0x3f, "Text record language code must be 2 to 63 characters");
+	record<LangLen + Len> out{ NDEF_TNF_WELL_KNOWN, 1, 0, LangLen + Len - 1, {} };
+	out.data[0] = 'T';
+	out.data[1] = (uint8_t) (LangLen - 1);
+	detail::copy(out.data, 2, lang, LangLen - 1);
+	detail::copy(out.data, 1 + LangLen, text, Len - 1);
+	return out;
+}
+
+// Encode records into a message, with room for the largest possible headers.
+template <size_t... Caps>
+constexpr message_buf<((Caps + 7) + ... + 0)> message(const record<Caps> &... recs) {
+	message_buf<((Caps + 7) + ... + 0)> out{ 0, {} };
+	size_t count = sizeof...(Caps);
+	size_t i     = 0;
+	((out.len = detail::put(out.data, out.len, recs, i == 0, i == count - 1), i++), ...);
+	return out;
+}
+
+// Copy the first `Len` bytes of an encoded message into an exactly sized array.
+template <size_t Len, size_t Cap>
+constexpr std::array<uint8_t, Len> shrink(const message_buf<Cap> &msg) {
+	static_assert(Len <= Cap, "Message is longer than its buffer");
+	std::array<uint8_t, Len> out{};
+	for (size_t i = 0; i < Len; i++) out[i] = msg.data[i];
+	return out;
+}
+
+} // namespace ndef_static
+
+// Declare `name` as a `static constexpr std::array<uint8_t, N>` containing the encoded records,
+// where N is exactly the encoded length.
+#define NDEF_STATIC_MESSAGE(name, ...) \
+	static constexpr auto name##_buf_ = ::ndef_static::message(__VA_ARGS__); \
+	static constexpr auto name = ::ndef_static::shrink<name##_buf_.len>(name##_buf_)
@@ -0,0 +1,112 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "ndef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// State of an incremental NDEF parser.
+typedef enum {
+	// More data is required to finish the message.
+	NDEF_PARSER_MORE,
+	// The last record of the message has been parsed.
+	NDEF_PARSER_DONE,
+	// The record callback asked to stop parsing.
+	NDEF_PARSER_STOPPED,
+	// Invalid data or out of memory.
+	NDEF_PARSER_ERROR,
+} ndef_parser_status;
+
+// Called by the parser for every record as soon as all of its data has arrived.
+// The data in `record` is only valid for the duration of the call; use `ndef_append` to keep it.
+// Chunked records are passed on one chunk at a time, as indicated by `flag_chunked` and `NDEF_TNF_UNCHANGED`.
+// Return false to stop parsing.
+typedef bool (*ndef_parser_cb)(void *cookie, const ndef_raw_record *record);
+
+#ifdef NDEF_REVEAL_PRIVATE
+
+// Resumable state for parsing NDEF data that arrives in pieces.
+typedef struct {
+	// Callback for completed records.
+	ndef_parser_cb     cb;
+	// Cookie passed to `cb`.
+	void              *cookie;
+	// Current parser state.
+	ndef_parser_status status;
+	// Reason for the `NDEF_PARSER_ERROR` state.
+	ndef_err           error;
+	
+	// Buffer for a record that spans multiple chunks.
+	uint8_t           *buf;
+	// Number of bytes of the current record in `buf`.
+	size_t             buf_len;
+	// Capacity of `buf`.
+	size_t             buf_cap;
+	// Total length of the current record, or 0 if its header is incomplete.
+	size_t             record_len;
+	
+	// Total amount of data consumed.
+	size_t             offset;
+} ndef_parser_s;
+
+// Resumable state for parsing NDEF data that arrives in pieces.
+typedef ndef_parser_s *ndef_parser;
+
+#else
+
+// Resumable state for parsing NDEF data that arrives in pieces.
+typedef void *ndef_parser;
+
+#endif
+
+// Create an incremental parser that calls `cb` for every complete record.
+ndef_parser			ndef_parser_init	(ndef_parser_cb cb, void *cookie);
+// Destroy an incremental parser.
+void				ndef_parser_destroy	(ndef_parser ctx);
+// Reset an incremental parser to start parsing a new message.
+void				ndef_parser_reset	(ndef_parser ctx);
+// Feed a chunk of NDEF data into the parser.
+// Sets `len` to the amount of data consumed, which is less than given only when parsing stops.
+ndef_parser_status	ndef_parser_feed	(ndef_parser ctx, const uint8_t *data, size_t *len);
+// Get the current state of the parser.
+ndef_parser_status	ndef_parser_get_status(ndef_parser ctx);
+// Get the reason the parser is in the `NDEF_PARSER_ERROR` state, or `NDEF_OK`.
+// The error occurred at `ndef_parser_offset`.
+ndef_err			ndef_parser_get_error(ndef_parser ctx);
+// Get the minimum number of bytes required before the next record can complete.
+// Returns 0 if the parser will not accept more data.
+size_t				ndef_parser_needed	(ndef_parser ctx);
+// Get the total amount of data consumed since the start of the message.
+size_t				ndef_parser_offset	(ndef_parser ctx);
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
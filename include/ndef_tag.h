@@ -0,0 +1,138 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+
+#include "ndef.h"
+#include "ndef_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Size of the block cache of a tag reader, which limits the size of a single read.
+#ifndef NDEF_TAG_CACHE_SIZE
+#define NDEF_TAG_CACHE_SIZE 64
+#endif
+
+// Default read size for Type 2 tags, which is what one READ command returns.
+#define NDEF_TAG_T2_BLOCK_SIZE 16
+// File ID of the capability container file of Type 4 tags.
+#define NDEF_TAG_T4_CC_FILE    0xE103
+
+// Kind of tag memory layout.
+typedef enum {
+	// NFC Forum Type 2 tag: CC in page 3, TLVs from page 4 on.
+	NDEF_TAG_TYPE2,
+	// NFC Forum Type 4 tag: CC file and NDEF file with an NLEN prefix.
+	NDEF_TAG_TYPE4,
+} ndef_tag_type;
+
+// Reads `len` bytes of tag memory at `offset` into `buf`.
+// For Type 2 tags, `file` is 0 and `offset` counts bytes from the start of page 0;
+// reads are aligned to the block size, so a READ command can serve them directly.
+// For Type 4 tags, `file` is the file to read with READ BINARY; selecting the NDEF application is up to the caller.
+// Returns false if the read failed.
+typedef bool (*ndef_tag_read_cb)(void *cookie, uint16_t file, size_t offset, uint8_t *buf, size_t len);
+
+// Where an NDEF message is stored on a tag, as found by `ndef_tag_locate`.
+typedef struct {
+	// File that holds the message; 0 for Type 2 tags.
+	uint16_t file;
+	// Offset of the first byte of the message.
+	size_t   offset;
+	// Length of the message.
+	size_t   len;
+	// Maximum message length the tag can hold.
+	size_t   capacity;
+	// Whether the capability container allows writing.
+	bool     writable;
+} ndef_tag_info;
+
+#ifdef NDEF_REVEAL_PRIVATE
+
+// Reader for NDEF messages in tag memory.
+typedef struct {
+	// Memory layout of the tag.
+	ndef_tag_type    type;
+	// Function that reads tag memory.
+	ndef_tag_read_cb read;
+	// Cookie passed to `read`.
+	void            *cookie;
+	// Maximum number of bytes per read.
+	size_t           block_size;
+	// Reason the last operation failed.
+	ndef_err         error;
+	
+	// File of the cached block.
+	uint16_t         cache_file;
+	// Offset of the cached block.
+	size_t           cache_offset;
+	// Number of valid bytes in the cache, or 0 if empty.
+	size_t           cache_len;
+	// Most recently read block.
+	uint8_t          cache[NDEF_TAG_CACHE_SIZE];
+} ndef_tag_s;
+
+// Reader for NDEF messages in tag memory.
+typedef ndef_tag_s *ndef_tag;
+
+#else
+
+// Reader for NDEF messages in tag memory.
+typedef void *ndef_tag;
+
+#endif
+
+// Create a reader for tag memory accessed through `read`.
+ndef_tag			ndef_tag_init		(ndef_tag_type type, ndef_tag_read_cb read, void *cookie);
+// Destroy a tag reader.
+void				ndef_tag_destroy	(ndef_tag ctx);
+// Set the maximum number of bytes per read, up to `NDEF_TAG_CACHE_SIZE`.
+// For Type 4 tags this is lowered further to the MLe from the capability container.
+void				ndef_tag_set_block_size(ndef_tag ctx, size_t block_size);
+// Forget cached tag memory, e.g. after the tag was written or replaced.
+void				ndef_tag_invalidate	(ndef_tag ctx);
+// Get the reason the last operation on the tag failed, or `NDEF_OK`.
+ndef_err			ndef_tag_get_error	(ndef_tag ctx);
+
+// Parse the capability container and find the NDEF message, reading as little as possible.
+// Lock and memory control TLVs are skipped; reserved areas inside the NDEF TLV are not supported.
+bool				ndef_tag_locate		(ndef_tag ctx, ndef_tag_info *out);
+// Feed the NDEF message located by `ndef_tag_locate` into `parser` until it is done or stops.
+// Only the blocks covering the message are read, and reading ends as soon as the parser stops.
+// Returns the state of the parser, which is `NDEF_PARSER_MORE` if the message is cut short.
+ndef_parser_status	ndef_tag_parse		(ndef_tag ctx, const ndef_tag_info *info, ndef_parser parser);
+// Read the NDEF message located by `ndef_tag_locate` into `buf`.
+// Fails if `cap` is less than `info->len`.
+bool				ndef_tag_read_into	(ndef_tag ctx, const ndef_tag_info *info, uint8_t *buf, size_t cap);
+// Locate, read and decode the NDEF message on a tag.
+// Returns NULL if there is no valid message or when out of memory.
+ndef_ctx			ndef_tag_decode		(ndef_tag ctx);
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -39,18 +39,42 @@ typedef struct {
 	char *text;
 } ndef_text;
 
+// The language and text of a text record, pointing into the record.
+typedef struct {
+	// ISO/IANA language code; not NUL-terminated.
+	const char    *lang;
+	// Length of the language code.
+	size_t         lang_len;
+	// Text data, UTF-8 or UTF-16 depending on `is_utf16`; not NUL-terminated.
+	const uint8_t *text;
+	// Length of the text data in bytes.
+	size_t         text_len;
+	// Whether the text is encoded as UTF-16 instead of UTF-8.
+	bool           is_utf16;
+} ndef_text_view;
+
 // Determine whether an NDEF record is a text record.
 bool ndef_record_is_text(ndef_record ctx);
+// Get the language and text of a text record without copying.
+// Returns false when not a text record.
+bool ndef_record_get_text_view(ndef_record ctx, ndef_text_view *out);
+// Write the text of a text record as UTF-8 into `buf`, which is NUL-terminated if `cap` is nonzero.
+// Returns the length of the full text even if it was truncated, or 0 when not a text record.
+size_t ndef_record_get_text_into(ndef_record ctx, char *buf, size_t cap);
+// Convert UTF-16 text to UTF-8, honouring a byte order mark if present and big-endian otherwise.
+// The output is NUL-terminated if `cap` is nonzero, and is truncated at the last whole character that fits.
+// Returns the length of the full UTF-8 text, excluding the NUL terminator.
+size_t ndef_utf16_to_utf8(const uint8_t *in, size_t in_len, char *out, size_t cap);
 // Construct a `ndef_text` containing both the text and language from the record.
 // Returns NULL when out of memory, or when not a text record.
 ndef_text ndef_record_get_text(ndef_record ctx);
 // Construct an NDEF record containing the given text and language.
 ndef_record ndef_record_new_text(ndef_text ctx);
 
-// Calls `free` on `lang` and `text` in an `ndef_text` struct.
+// Calls `ndef_free` on `lang` and `text` in an `ndef_text` struct.
 static inline void ndef_text_destroy(ndef_text ctx) {
-	if (ctx.lang) free(ctx.lang);
-	if (ctx.text) free(ctx.text);
+	if (ctx.lang) ndef_free(ctx.lang, NDEF_ALLOC_OUTPUT);
+	if (ctx.text) ndef_free(ctx.text, NDEF_ALLOC_OUTPUT);
 }
 
 
@@ -73,11 +73,70 @@ typedef enum {
 	NDEF_URI_ABBREVMAX
 } ndef_uri_abbrev;
 
+// List of URI abbreviations in order of their `ndef_uri_abbrev` value, as an X-macro.
+#define NDEF_URI_ABBREVS(X) \
+	X("") \
+	X("http://www.") \
+	X("https://www.") \
+	X("http://") \
+	X("https://") \
+	X("tel:") \
+	X("mailto:") \
+	X("ftp://anonymous:anonymous@") \
+	X("ftp://ftp.") \
+	X("ftps://") \
+	X("sftp://") \
+	X("smb://") \
+	X("nfs://") \
+	X("ftp://") \
+	X("dav://") \
+	X("news:") \
+	X("telnet://") \
+	X("imap:") \
+	X("rtsp://") \
+	X("urn:") \
+	X("pop:") \
+	X("sip:") \
+	X("sips:") \
+	X("tftp:") \
+	X("btspp://") \
+	X("btl2cap://") \
+	X("btgoep://") \
+	X("tcpobex://") \
+	X("irdaobex://") \
+	X("file://") \
+	X("urn:epc:id:") \
+	X("urn:epc:tag:") \
+	X("urn:epc:pat:") \
+	X("urn:epc:raw:") \
+	X("urn:epc:") \
+	X("urn:nfc:")
+
 // Table containing string values of URI abbreviations.
 extern const char *ndef_uri_abbrev_table[NDEF_URI_ABBREVMAX];
+// Table containing string lengths of URI abbreviations.
+extern const uint8_t ndef_uri_abbrev_len[NDEF_URI_ABBREVMAX];
+
+// The parts of a URI record's URI, pointing into static data and the record.
+typedef struct {
+	// Expanded abbreviation.
+	const char *prefix;
+	// Length of the expanded abbreviation.
+	size_t      prefix_len;
+	// Remainder of the URI; not NUL-terminated.
+	const char *rest;
+	// Length of the remainder.
+	size_t      rest_len;
+} ndef_uri_view;
 
 // Determine whether an NDEF record is a URI record.
 bool ndef_record_is_uri(ndef_record ctx);
+// Get the expanded abbreviation and the remainder of a URI record without copying.
+// Returns false when not a URI record.
+bool ndef_record_get_uri_view(ndef_record ctx, ndef_uri_view *out);
+// Write the full URI from a URI record into `buf`, which is NUL-terminated if `cap` is nonzero.
+// Returns the length of the full URI even if it was truncated, or 0 when not a URI record.
+size_t ndef_record_get_uri_into(ndef_record ctx, char *buf, size_t cap);
 // Construct a string containing the full URI from a URI record.
 // Returns NULL when out of memory, or when not a URI record.
 char *ndef_record_get_uri(ndef_record ctx);
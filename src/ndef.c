@@ -25,8 +25,22 @@
 #define NDEF_REVEAL_PRIVATE
 #include "ndef.h"
 #include "ndef_record_types.h"
+#include "ndef_log.h"
+#include "ndef_stats.h"
 
-#define MAGIC_CHECK if (!ctx || ctx->magic != NDEF_MAGIC) { printf("NDEF: Fatal error: Invalid context\n"); abort(); }
+#include <stdarg.h>
+#include <stdatomic.h>
+
+// Marks an encoding entry that is not part of the baseline encoding.
+#define NO_OFFSET ((ndef_len_t) -1)
+
+#ifdef NDEF_MAGIC_CHECK_NO_ABORT
+// Log use of an invalid context and return `__VA_ARGS__` from the function.
+#define MAGIC_CHECK(...) if (!ctx || ctx->magic != NDEF_MAGIC) { NDEF_LOG(NDEF_LOG_ERROR, "Error: Invalid context"); return __VA_ARGS__; }
+#else
+// Abort on use of an invalid context.
+#define MAGIC_CHECK(...) if (!ctx || ctx->magic != NDEF_MAGIC) { printf("NDEF: Fatal error: Invalid context\n"); abort(); }
+#endif
 
 
 // LUT from ndef_tnf to name.
@@ -41,6 +55,127 @@ const char *ndef_tnf_names[8] = {
 	"Reserved (7)",
 };
 
+// LUT from ndef_err to name.
+const char *ndef_err_names[10] = {
+	"OK",
+	"TRUNCATED",
+	"CHUNK",
+	"FLAGS",
+	"TOO_LONG",
+	"NO_MEM",
+	"NO_SPACE",
+	"WRITE",
+	"INVALID",
+	"READ",
+};
+
+#ifdef NDEF_ENABLE_LOG
+// Function that receives diagnostic messages, or NULL to print them.
+static ndef_log_cb log_hook;
+// Cookie passed to `log_hook`.
+static void       *log_cookie;
+
+// Set the function that receives diagnostic messages, or NULL to print them.
+// Not thread-safe; set it before using the library.
+void ndef_set_log_hook(ndef_log_cb cb, void *cookie) {
+	log_hook   = cb;
+	log_cookie = cookie;
+}
+
+// Format a diagnostic message and pass it to the log hook.
+void ndef_log(ndef_log_level level, const char *fmt, ...) {
+	char    msg[128];
+	va_list va;
+	va_start(va, fmt);
+	vsnprintf(msg, sizeof(msg), fmt, va);
+	va_end(va);
+	
+	if (log_hook) {
+		log_hook(log_cookie, level, msg);
+	} else {
+		printf("NDEF: %s\n", msg);
+	}
+}
+#endif
+
+// LUT from ndef_phase to name.
+const char *ndef_phase_names[NDEF_PHASE_COUNT] = {
+	"OTHER",
+	"VALIDATE",
+	"RESERVE",
+	"HEADER",
+	"COPY",
+	"APPEND",
+	"ENCODE",
+};
+
+#ifdef NDEF_ENABLE_STATS
+// Counters for one phase, shared between threads.
+typedef struct {
+	atomic_size_t calls;
+	atomic_size_t allocs;
+	atomic_size_t alloc_bytes;
+} phase_counters;
+
+// Counters for all phases.
+static phase_counters        stats[NDEF_PHASE_COUNT];
+// Phase the current thread is in.
+static _Thread_local ndef_phase stats_phase = NDEF_PHASE_OTHER;
+// Function called when a phase begins, if any.
+static ndef_phase_cb         phase_begin_hook;
+// Function called when a phase ends, if any.
+static ndef_phase_cb         phase_end_hook;
+// Cookie passed to the phase hooks.
+static void                 *phase_cookie;
+
+// Get a snapshot of the phase counters.
+void ndef_stats_get(ndef_stats *out) {
+	for (size_t i = 0; i < NDEF_PHASE_COUNT; i++) {
+		out->phase[i] = (ndef_phase_stats) {
+			.calls       = atomic_load_explicit(&stats[i].calls,       memory_order_relaxed),
+			.allocs      = atomic_load_explicit(&stats[i].allocs,      memory_order_relaxed),
+			.alloc_bytes = atomic_load_explicit(&stats[i].alloc_bytes, memory_order_relaxed),
+		};
+	}
+}
+
+// Set all phase counters to zero.
+void ndef_stats_reset() {
+	for (size_t i = 0; i < NDEF_PHASE_COUNT; i++) {
+		atomic_store_explicit(&stats[i].calls,       0, memory_order_relaxed);
+		atomic_store_explicit(&stats[i].allocs,      0, memory_order_relaxed);
+		atomic_store_explicit(&stats[i].alloc_bytes, 0, memory_order_relaxed);
+	}
+}
+
+// Set the functions called when a phase begins and ends; either may be NULL.
+// Not thread-safe; set them before using the library.
+void ndef_set_phase_hooks(ndef_phase_cb begin, ndef_phase_cb end, void *cookie) {
+	phase_begin_hook = begin;
+	phase_end_hook   = end;
+	phase_cookie     = cookie;
+}
+
+// Enter a phase on the current thread.
+void ndef_stats_begin(ndef_phase phase) {
+	stats_phase = phase;
+	atomic_fetch_add_explicit(&stats[phase].calls, 1, memory_order_relaxed);
+	if (phase_begin_hook) phase_begin_hook(phase_cookie, phase);
+}
+
+// Leave a phase on the current thread.
+void ndef_stats_end(ndef_phase phase) {
+	if (phase_end_hook) phase_end_hook(phase_cookie, phase);
+	stats_phase = NDEF_PHASE_OTHER;
+}
+
+// Count an allocation of `bytes` bytes against the current thread's phase.
+void ndef_stats_alloc(size_t bytes) {
+	atomic_fetch_add_explicit(&stats[stats_phase].allocs,      1,     memory_order_relaxed);
+	atomic_fetch_add_explicit(&stats[stats_phase].alloc_bytes, bytes, memory_order_relaxed);
+}
+#endif
+
 
 
 // BOX used for output streaming.
@@ -51,49 +186,106 @@ typedef struct {
 	size_t   buf_cap;
 	// Length of buffer.
 	size_t   buf_len;
+	// Whether `buf` is caller memory that may not be grown.
+	bool     fixed;
+	// Sink to write the data to instead of keeping it, if any.
+	// If so, `buf` is an optional staging buffer used to batch writes.
+	ndef_write_cb write;
+	// Cookie passed to `write`.
+	void    *cookie;
+	// Reason writing to the stream failed.
+	ndef_err error;
 } ndef_ostream;
 
 // Make an `ndef_ostream`.
 static inline ndef_ostream ndef_ostream_init() {
-	return (ndef_ostream) { NULL, 0, 0 };
+	return (ndef_ostream) { NULL, 0, 0, false, NULL, NULL, NDEF_OK };
+}
+
+// Make an `ndef_ostream` that writes into caller memory.
+static inline ndef_ostream ndef_ostream_init_fixed(uint8_t *buf, size_t cap) {
+	return (ndef_ostream) { buf, cap, 0, true, NULL, NULL, NDEF_OK };
+}
+
+// Make an `ndef_ostream` that passes data on to a sink, batched through `buf` if not NULL.
+static inline ndef_ostream ndef_ostream_init_sink(ndef_write_cb write, void *cookie, uint8_t *buf, size_t cap) {
+	return (ndef_ostream) { buf, buf ? cap : 0, 0, true, write, cookie, NDEF_OK };
 }
 
 // Destroy an `ndef_ostream`.
 static inline void ndef_ostream_destroy(ndef_ostream ctx) {
-	if (ctx.buf) free(ctx.buf);
+	if (ctx.buf && !ctx.fixed) ndef_free(ctx.buf, NDEF_ALLOC_OUTPUT);
 }
 
-// Append one (1) byte (eight (8) bit (either one (1) or zero (0)) quantity (amount)) to the output stream.
-static bool ndef_ostream_append(ndef_ostream *ctx, uint8_t data) {
-	if (ctx->buf_len >= ctx->buf_cap) {
-		size_t cap = ctx->buf_cap * 2;
-		if (!cap) cap = 1;
-		void *mem = realloc(ctx->buf, cap);
-		if (!mem) {
-			printf("NDEF: Error: Out of memory (allocating %zu byte%s)\n", cap, cap == 1 ? "" : "s");
-			return false;
-		}
-		ctx->buf = mem;
-		ctx->buf_cap = cap;
+// Make sure the output stream has room for `len` more bytes.
+static bool ndef_ostream_reserve(ndef_ostream *ctx, size_t len) {
+	if (ctx->write) return true;
+	if (ctx->buf_cap - ctx->buf_len >= len) return true;
+	if (ctx->fixed) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Not enough space (%zu bytes; expected %zu+ bytes)", ctx->buf_cap, ctx->buf_len + len);
+		ctx->error = NDEF_ERR_NO_SPACE;
+		return false;
+	}
+	size_t cap = ctx->buf_cap;
+	if (!cap) cap = 1;
+	while (cap < ctx->buf_len + len) cap *= 2;
+	void *mem = ndef_realloc(ctx->buf, cap, NDEF_ALLOC_OUTPUT);
+	if (!mem) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu byte%s)", cap, cap == 1 ? "" : "s");
+		ctx->error = NDEF_ERR_NO_MEM;
+		return false;
 	}
-	ctx->buf[ctx->buf_len++] = data;
+	ctx->buf = mem;
+	ctx->buf_cap = cap;
 	return true;
 }
 
-// Append MULTI-BYTE DATA to the output stream.
-static bool ndef_ostream_append_n(ndef_ostream *ctx, uint8_t *data, size_t len) {
-	size_t cap = ctx->buf_cap;
-	if (!cap) cap = 1;
-	if (cap < ctx->buf_len + len) {
-		while (cap < ctx->buf_len + len) cap *= 2;
-		void *mem = realloc(ctx->buf, cap);
-		if (!mem) {
-			printf("NDEF: Error: Out of memory (allocating %zu byte%s)\n", cap, cap == 1 ? "" : "s");
-			return false;
+// Write the batched data in the staging buffer to the sink.
+static bool ndef_ostream_flush(ndef_ostream *ctx) {
+	if (!ctx->write || !ctx->buf_len) return true;
+	bool res = ctx->write(ctx->cookie, ctx->buf, ctx->buf_len);
+	ctx->buf_len = 0;
+	if (!res) ctx->error = NDEF_ERR_WRITE;
+	return res;
+}
+
+// Pass MULTI-BYTE DATA on to the sink, in batches if there is a staging buffer.
+static bool ndef_ostream_write_n(ndef_ostream *ctx, const uint8_t *data, size_t len) {
+	if (!ctx->buf_cap) {
+		if (ctx->write(ctx->cookie, data, len)) return true;
+		ctx->error = NDEF_ERR_WRITE;
+		return false;
+	}
+	
+	while (len) {
+		if (!ctx->buf_len && len >= ctx->buf_cap) {
+			// Whole batches can skip the staging buffer.
+			size_t direct = len - len % ctx->buf_cap;
+			if (!ctx->write(ctx->cookie, data, direct)) {
+				ctx->error = NDEF_ERR_WRITE;
+				return false;
+			}
+			data += direct;
+			len  -= direct;
+		} else {
+			// Collect the rest in the staging buffer.
+			size_t copy = ctx->buf_cap - ctx->buf_len;
+			if (copy > len) copy = len;
+			memcpy(ctx->buf + ctx->buf_len, data, copy);
+			ctx->buf_len += copy;
+			data += copy;
+			len  -= copy;
+			if (ctx->buf_len == ctx->buf_cap && !ndef_ostream_flush(ctx)) return false;
 		}
-		ctx->buf = mem;
-		ctx->buf_cap = cap;
 	}
+	
+	return true;
+}
+
+// Append MULTI-BYTE DATA to the output stream.
+static bool ndef_ostream_append_n(ndef_ostream *ctx, const uint8_t *data, size_t len) {
+	if (ctx->write) return ndef_ostream_write_n(ctx, data, len);
+	if (!ndef_ostream_reserve(ctx, len)) return false;
 	memcpy(ctx->buf + ctx->buf_len, data, len);
 	ctx->buf_len += len;
 	return true;
@@ -101,92 +293,132 @@ static bool ndef_ostream_append_n(ndef_ostream *ctx, uint8_t *data, size_t len)
 
 
 
-// Prints a simple hexdump.
-static void hexdump(const void *datas, size_t size, int indent) {
-	const size_t cols = 16;
-	const uint8_t *arr = datas;
-	for (size_t y = 0; y * cols < size; y++) {
-		// Print indentation.
-		for (int x = 0; x < indent; x++) putc(' ', stdout);
-		
-		// Print hex chars.
-		uint_fast8_t x;
-		for (x = 0; x < cols && x+y*cols < size; x++) {
-			if (x) putc(' ', stdout);
-			printf("%02x", arr[y*cols+x]);
-		}
-		// Padding.
-		if (size > 16) {
-			if (!x) { x++; fputs("  ", stdout); }
-			for (; x < cols; x++) fputs("   ", stdout);
-		}
-		
-		// Print ASCII chars.
-		fputs("  ", stdout);
-		for (x = 0; x < cols && x+y*cols < size; x++) {
-			char c = arr[y*cols+x];
-			if (c >= 0x20 && c <= 0x7e) putc(c, stdout);
-			else putc('.', stdout);
-		}
-		putc('\n', stdout);
+// Allocate memory with the context's allocator.
+static void *ctx_malloc(ndef_ctx ctx, size_t size, ndef_alloc_kind kind) {
+	NDEF_STATS_ALLOC(size);
+	return ctx->alloc->alloc(ctx->alloc->cookie, size, kind);
+}
+
+// Resize memory allocated with the context's allocator.
+static void *ctx_realloc(ndef_ctx ctx, void *ptr, size_t size, ndef_alloc_kind kind) {
+	NDEF_STATS_ALLOC(size);
+	return ctx->alloc->realloc(ctx->alloc->cookie, ptr, size, kind);
+}
+
+// Free memory allocated with the context's allocator.
+static void ctx_free(ndef_ctx ctx, void *ptr, ndef_alloc_kind kind) {
+	ctx->alloc->free(ctx->alloc->cookie, ptr, kind);
+}
+
+// Note down why an operation on `ctx` failed.
+// Always returns false.
+static bool fail(ndef_ctx ctx, ndef_err error, size_t offset) {
+	ctx->error        = error;
+	ctx->error_offset = offset;
+	return false;
+}
+
+// Note down that a static context cannot grow an array of `max` entries to `cap` entries.
+// Always returns false.
+static bool fixed_full(ndef_ctx ctx, size_t cap, size_t max) {
+	(void) cap;
+	(void) max;
+	NDEF_LOG(NDEF_LOG_ERROR, "Error: Too many records for static context (%zu; maximum is %zu)", cap, max);
+	return fail(ctx, NDEF_ERR_TOO_LONG, 0);
+}
+
+// Make sure the context has capacity for at least `cap` raw record encoding details.
+static bool enc_reserve(ndef_ctx ctx, size_t cap) {
+	if (cap <= ctx->enc_cap) return true;
+	if (cap > NDEF_MAX_RECORDS) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Too many records (%zu; maximum is %zu)", cap, (size_t) NDEF_MAX_RECORDS);
+		return fail(ctx, NDEF_ERR_TOO_LONG, 0);
+	}
+	if (ctx->fixed) return fixed_full(ctx, cap, ctx->enc_cap);
+	void *mem = ctx_realloc(ctx, ctx->enc, sizeof(ndef_enc_entry) * cap, NDEF_ALLOC_ARRAY);
+	if (!mem) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", sizeof(ndef_enc_entry) * cap);
+		return fail(ctx, NDEF_ERR_NO_MEM, 0);
 	}
+	ctx->enc     = mem;
+	ctx->enc_cap = cap;
+	return true;
 }
 
-// Append a raw NDEF record.
+// Append the encoding details of a raw NDEF record.
 bool ndef_raw_append(ndef_ctx ctx, ndef_raw_record record) {
-	MAGIC_CHECK
+	MAGIC_CHECK(false)
+	
+	// Raw records must belong to an abstract record.
+	if (record.abs_index >= ctx->abs_records_len) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Raw record refers to nonexistent record %zu", (size_t) record.abs_index);
+		return fail(ctx, NDEF_ERR_INVALID, 0);
+	}
 	
 	// Determine new capacity.
-	size_t cap = ctx->raw_records_cap;
-	if (ctx->raw_records_len >= cap) {
-		if (!cap) cap = 1;
-		cap *= 2;
-		void *mem = realloc(ctx->raw_records, sizeof(ndef_raw_record) * cap);
-		if (!mem) {
-			printf("NDEF: Error: Out of memory (allocating %zu bytes)\n", sizeof(ndef_raw_record) * cap);
-			return false;
-		}
-		ctx->raw_records     = mem;
-		ctx->raw_records_cap = cap;
+	if (ctx->enc_len >= NDEF_MAX_RECORDS) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Too many records (maximum is %zu)", (size_t) NDEF_MAX_RECORDS);
+		return fail(ctx, NDEF_ERR_TOO_LONG, 0);
+	} else if (ctx->enc_len >= ctx->enc_cap) {
+		size_t cap = ctx->enc_cap ? ctx->enc_cap * 2 : 1;
+		if (cap > NDEF_MAX_RECORDS) cap = NDEF_MAX_RECORDS;
+		if (!enc_reserve(ctx, cap)) return false;
 	}
 	
-	// Copy an element.
-	ctx->raw_records[ctx->raw_records_len] = record;
-	ctx->raw_records_len ++;
+	// Locate the raw record's part of the abstract payload.
+	ndef_record *abs   = ctx->abs_records + record.abs_index;
+	size_t      offset = 0;
+	if (abs->payload && record.payload >= abs->payload && record.payload <= abs->payload + abs->payload_len) {
+		offset = record.payload - abs->payload;
+	}
+	
+	// Link the abstract record to it.
+	if (!abs->raw_len) abs->raw_index = ctx->enc_len;
+	abs->raw_len ++;
+	
+	// Store the encoding details only; the data lives in the abstract record.
+	ctx->enc[ctx->enc_len] = (ndef_enc_entry) {
+		.detail         = record.enc_detail,
+		.payload_offset = offset,
+		.payload_len    = record.payload_len,
+		.enc_offset     = NO_OFFSET,
+	};
+	ctx->enc_len ++;
 	
 	return true;
 }
 
-// Clone an ndef_raw_record.
+// Make a deep copy of an NDEF record, which owns all of its fields.
 // This method is an excellent example of something C++ is way better at than C is.
 bool ndef_record_clone(ndef_record in, ndef_record *out) {
 	ndef_record tmp = in;
+	tmp.borrowed    = 0;
 	
 	if (in.payload) {
-		tmp.payload = malloc(in.payload_len);
+		tmp.payload = ndef_malloc(in.payload_len, NDEF_ALLOC_PAYLOAD);
 		if (!tmp.payload) {
-			printf("NDEF: Error: Out of memory (allocating %zu byte%s)\n", in.payload_len, in.payload_len == 1 ? "" : "s");
+			NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu byte%s)", (size_t) in.payload_len, in.payload_len == 1 ? "" : "s");
 			return false;
 		}
 		memcpy(tmp.payload, in.payload, in.payload_len);
 	}
 	
 	if (in.type) {
-		tmp.type = malloc(in.type_len);
+		tmp.type = ndef_malloc(in.type_len, NDEF_ALLOC_FIELD);
 		if (!tmp.type) {
-			printf("NDEF: Error: Out of memory (allocating %zu byte%s)\n", in.type_len, in.type_len == 1 ? "" : "s");
-			if (tmp.payload) free(tmp.payload);
+			NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu byte%s)", (size_t) in.type_len, in.type_len == 1 ? "" : "s");
+			if (tmp.payload) ndef_free(tmp.payload, NDEF_ALLOC_PAYLOAD);
 			return false;
 		}
 		memcpy(tmp.type, in.type, in.type_len);
 	}
 	
 	if (in.id) {
-		tmp.id = malloc(in.id_len);
-		if (!tmp.type) {
-			printf("NDEF: Error: Out of memory (allocating %zu byte%s)\n", in.id_len, in.id_len == 1 ? "" : "s");
-			if (tmp.payload) free(tmp.type);
-			if (tmp.payload) free(tmp.payload);
+		tmp.id = ndef_malloc(in.id_len, NDEF_ALLOC_FIELD);
+		if (!tmp.id) {
+			NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu byte%s)", (size_t) in.id_len, in.id_len == 1 ? "" : "s");
+			if (tmp.type) ndef_free(tmp.type, NDEF_ALLOC_FIELD);
+			if (tmp.payload) ndef_free(tmp.payload, NDEF_ALLOC_PAYLOAD);
 			return false;
 		}
 		memcpy(tmp.id, in.id, in.id_len);
@@ -196,14 +428,16 @@ bool ndef_record_clone(ndef_record in, ndef_record *out) {
 	return true;
 }
 
-// Decode a single NDEF record from a blob of data.
+// Decode a single NDEF record from a blob of data without copying.
+// The `type`, `payload` and `id` of `out` will point into `data`.
 // Sets `len` to the amount of successfully decoded data when finished.
-bool ndef_raw_record_decode(ndef_raw_record *out, uint8_t *data, size_t *len) {
-	ndef_raw_record tmp;
+bool ndef_raw_record_decode_view(ndef_raw_record *out, uint8_t *data, size_t *len) {
+	ndef_raw_record tmp = ndef_raw_record_init();
+	tmp.borrowed        = NDEF_BORROW_ALL;
 	
 	// Minimum length check.
 	if (*len < 3) {
-		printf("NDEF: Decode error: Not enough data (%zu byte%s; expected 3+ bytes)\n", *len, *len == 1 ? "" : "s");
+		NDEF_LOG(NDEF_LOG_ERROR, "Decode error: Not enough data (%zu byte%s; expected 3+ bytes)", *len, *len == 1 ? "" : "s");
 		return false;
 	}
 	
@@ -219,10 +453,10 @@ bool ndef_raw_record_decode(ndef_raw_record *out, uint8_t *data, size_t *len) {
 	
 	// Minimum length check.
 	if (tmp.flag_short_record && *len < 3 + tmp.flag_include_id_len) {
-		printf("NDEF: Decode error: Not enough data (%zu bytes; expected %zu+ bytes)\n", *len, 3 + tmp.flag_include_id_len);
+		NDEF_LOG(NDEF_LOG_ERROR, "Decode error: Not enough data (%zu bytes; expected %zu+ bytes)", *len, (size_t) 3 + tmp.flag_include_id_len);
 		return false;
-	} else if (!tmp.flag_short_record && *len < 5 + tmp.flag_include_id_len) {
-		printf("NDEF: Decode error: Not enough data (%zu bytes; expected %zu+ bytes)\n", *len, 5 + tmp.flag_include_id_len);
+	} else if (!tmp.flag_short_record && *len < 6 + tmp.flag_include_id_len) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Decode error: Not enough data (%zu bytes; expected %zu+ bytes)", *len, (size_t) 6 + tmp.flag_include_id_len);
 		return false;
 	}
 	
@@ -234,10 +468,10 @@ bool ndef_raw_record_decode(ndef_raw_record *out, uint8_t *data, size_t *len) {
 		tmp.payload_len = data[pos++];
 	} else {
 		tmp.payload_len = 0;
-		tmp.payload_len |= data[pos++] << 24;
-		tmp.payload_len |= data[pos++] << 16;
-		tmp.payload_len |= data[pos++] <<  8;
-		tmp.payload_len |= data[pos++] <<  0;
+		tmp.payload_len |= (size_t) data[pos++] << 24;
+		tmp.payload_len |= (size_t) data[pos++] << 16;
+		tmp.payload_len |= (size_t) data[pos++] <<  8;
+		tmp.payload_len |= (size_t) data[pos++] <<  0;
 	}
 	
 	// ID length.
@@ -247,65 +481,43 @@ bool ndef_raw_record_decode(ndef_raw_record *out, uint8_t *data, size_t *len) {
 		tmp.id_len = 0;
 	}
 	
-	// Minimum length check.
-	if (*len < pos + tmp.type_len + tmp.payload_len + tmp.id_len) {
-		printf("NDEF: Debug: 0x%02x %zu %zu %zu %zu\n", data[0], pos, tmp.type_len, tmp.payload_len, tmp.id_len);
-		printf("NDEF: Decode error: Not enough data (%zu bytes; expected %zu bytes)\n", *len, pos + tmp.type_len + tmp.payload_len + tmp.id_len);
+	// Minimum length check; each field is taken off the remaining length so the sum cannot overflow.
+	size_t avail = *len - pos;
+	if (tmp.payload_len > avail || (size_t) tmp.type_len + tmp.id_len > avail - tmp.payload_len) {
+		NDEF_LOG(NDEF_LOG_DEBUG, "Debug: 0x%02x %zu %zu %zu %zu", data[0], pos, (size_t) tmp.type_len, (size_t) tmp.payload_len, (size_t) tmp.id_len);
+		NDEF_LOG(NDEF_LOG_ERROR, "Decode error: Not enough data (%zu bytes after the %zu byte header; expected %zu + %zu + %zu bytes)",
+			avail, pos, (size_t) tmp.type_len, (size_t) tmp.payload_len, (size_t) tmp.id_len);
 		return false;
 	}
 	
 	// Type field.
-	if (tmp.type_len) {
-		tmp.type = malloc(tmp.type_len);
-		if (!tmp.type) {
-			printf("NDEF: Error: Out of memory (allocating %zu bytes)\n", (size_t) tmp.type_len);
-			return false;
-		}
-		memcpy(tmp.type, data + pos, tmp.type_len);
-		pos += tmp.type_len;
-	} else {
-		tmp.type = NULL;
-	}
+	tmp.type    = tmp.type_len    ? data + pos : NULL;
+	pos += tmp.type_len;
 	
 	// Payload field.
-	if (tmp.payload_len) {
-		tmp.payload = malloc(tmp.payload_len);
-		if (!tmp.payload) {
-			if (tmp.type) free(tmp.type);
-			printf("NDEF: Error: Out of memory (allocating %zu bytes)\n", (size_t) tmp.payload_len);
-			return false;
-		}
-		memcpy(tmp.payload, data + pos, tmp.payload_len);
-		pos += tmp.payload_len;
-	} else {
-		tmp.payload = NULL;
-	}
+	tmp.payload = tmp.payload_len ? data + pos : NULL;
+	pos += tmp.payload_len;
 	
 	// ID field.
-	if (tmp.id_len) {
-		tmp.id = malloc(tmp.id_len);
-		if (!tmp.id) {
-			if (tmp.type) free(tmp.type);
-			if (tmp.payload) free(tmp.payload);
-			printf("NDEF: Error: Out of memory (allocating %zu bytes)\n", (size_t) tmp.id_len);
-			return false;
-		}
-		memcpy(tmp.id, data + pos, tmp.id_len);
-		pos += tmp.id_len;
-	} else {
-		tmp.id = NULL;
-	}
+	tmp.id      = tmp.id_len      ? data + pos : NULL;
+	pos += tmp.id_len;
 	
-	// SUCCESSFUL DECODE YAY!
 	*out = tmp;
 	*len = pos;
 	return true;
 }
 
-// Encode a single NDEF record.
-bool ndef_raw_record_encode(ndef_ostream *out, const ndef_raw_record *data) {
-	size_t len0 = out->buf_len;
-	
+// Determine the encoded size of a single NDEF record.
+size_t ndef_raw_record_size(const ndef_raw_record *data) {
+	size_t len = 2;
+	len += data->flag_short_record ? 1 : 4;
+	if (data->flag_include_id_len) len += 1 + data->id_len;
+	return len + data->type_len + data->payload_len;
+}
+
+// Encode the header of a single NDEF record into `header`, which has room for `NDEF_RAW_HEADER_MAX` bytes.
+// Returns the length of the header.
+size_t ndef_raw_record_encode_header(const ndef_raw_record *data, uint8_t *header) {
 	// Create flags field.
 	uint8_t flags = 0;
 	flags |= NDEF_FLAG_MB  * data->flag_begin;
@@ -314,30 +526,44 @@ bool ndef_raw_record_encode(ndef_ostream *out, const ndef_raw_record *data) {
 	flags |= NDEF_FLAG_SR  * data->flag_short_record;
 	flags |= NDEF_FLAG_IL  * data->flag_include_id_len;
 	flags |= NDEF_FLAG_TNF & data->tnf;
-	bool res = ndef_ostream_append(out, flags);
-	if (!res) { out->buf_len = len0; return false; }
+	
+	// Assemble the header.
+	size_t header_len = 0;
+	header[header_len++] = flags;
 	
 	// Type length.
-	res = ndef_ostream_append(out, data->type_len);
-	if (!res) { out->buf_len = len0; return false; }
+	header[header_len++] = data->type_len;
 	
 	// Payload length.
 	if (data->flag_short_record) {
-		res = ndef_ostream_append(out, data->payload_len);
+		header[header_len++] = data->payload_len;
 	} else {
-		res  = ndef_ostream_append(out, data->payload_len >> 24);
-		res &= ndef_ostream_append(out, data->payload_len >> 16);
-		res &= ndef_ostream_append(out, data->payload_len >>  8);
-		res &= ndef_ostream_append(out, data->payload_len >>  0);
-		if (!res) { out->buf_len = len0; return false; }
+		header[header_len++] = data->payload_len >> 24;
+		header[header_len++] = data->payload_len >> 16;
+		header[header_len++] = data->payload_len >>  8;
+		header[header_len++] = data->payload_len >>  0;
 	}
 	
 	// ID length.
 	if (data->flag_include_id_len) {
-		res = ndef_ostream_append(out, data->id_len);
-		if (!res) { out->buf_len = len0; return false; }
+		header[header_len++] = data->id_len;
 	}
 	
+	return header_len;
+}
+
+// Encode a single NDEF record.
+bool ndef_raw_record_encode(ndef_ostream *out, const ndef_raw_record *data) {
+	size_t len0 = out->buf_len;
+	
+	// Reserve space for the entire record at once.
+	if (!ndef_ostream_reserve(out, ndef_raw_record_size(data))) return false;
+	
+	uint8_t header[NDEF_RAW_HEADER_MAX];
+	size_t  header_len = ndef_raw_record_encode_header(data, header);
+	bool res = ndef_ostream_append_n(out, header, header_len);
+	if (!res) { out->buf_len = len0; return false; }
+	
 	// Type.
 	if (data->type_len) {
 		res = ndef_ostream_append_n(out, data->type, data->type_len);
@@ -361,267 +587,706 @@ bool ndef_raw_record_encode(ndef_ostream *out, const ndef_raw_record *data) {
 
 
 
+// A separately allocated record field.
+typedef struct {
+	// The allocation.
+	void           *ptr;
+	// What it was allocated as.
+	ndef_alloc_kind kind;
+} pool_field;
+
+// Reference-counted record data shared by cloned contexts.
+struct ndef_pool_s {
+	// Number of contexts using this pool.
+	atomic_size_t refcount;
+	// Allocator of the original context, used for the pool and the arena.
+	const ndef_allocator *alloc;
+	// Older pool that the records may also point into, if any.
+	ndef_pool    *parent;
+	// Arena taken from the original context, if any.
+	uint8_t      *arena;
+	// Number of separately allocated fields.
+	size_t        fields_len;
+	// Separately allocated fields taken from the original context.
+	pool_field    fields[];
+};
+
+// Drop a reference to a pool, freeing it when no context uses it anymore.
+static void pool_release(ndef_pool *pool) {
+	while (pool && atomic_fetch_sub(&pool->refcount, 1) == 1) {
+		ndef_pool            *parent = pool->parent;
+		const ndef_allocator *alloc  = pool->alloc;
+		for (size_t i = 0; i < pool->fields_len; i++) {
+			ndef_free(pool->fields[i].ptr, pool->fields[i].kind);
+		}
+		if (pool->arena) alloc->free(alloc->cookie, pool->arena, NDEF_ALLOC_ARENA);
+		alloc->free(alloc->cookie, pool, NDEF_ALLOC_ARRAY);
+		pool = parent;
+	}
+}
+
+// Move all record data owned by `ctx` into a new pool, so it can be shared with clones.
+// Afterwards, all records in `ctx` borrow their data.
+static bool pool_share(ndef_ctx ctx) {
+	// Count the owned fields.
+	size_t owned = 0;
+	for (size_t i = 0; i < ctx->abs_records_len; i++) {
+		const ndef_record *rec = ctx->abs_records + i;
+		owned += rec->type    && !(rec->borrowed & NDEF_BORROW_TYPE);
+		owned += rec->payload && !(rec->borrowed & NDEF_BORROW_PAYLOAD);
+		owned += rec->id      && !(rec->borrowed & NDEF_BORROW_ID);
+	}
+	// Already shareable as-is.
+	if (!owned && !ctx->arena) return true;
+	
+	size_t     size = sizeof(ndef_pool) + sizeof(pool_field) * owned;
+	ndef_pool *pool = ctx_malloc(ctx, size, NDEF_ALLOC_ARRAY);
+	if (!pool) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", size);
+		return fail(ctx, NDEF_ERR_NO_MEM, 0);
+	}
+	atomic_init(&pool->refcount, 1);
+	pool->alloc      = ctx->alloc;
+	pool->parent     = ctx->pool;
+	pool->arena      = ctx->arena;
+	pool->fields_len = 0;
+	
+	// Take ownership of everything.
+	for (size_t i = 0; i < ctx->abs_records_len; i++) {
+		ndef_record *rec = ctx->abs_records + i;
+		if (rec->type    && !(rec->borrowed & NDEF_BORROW_TYPE))    pool->fields[pool->fields_len++] = (pool_field) { rec->type,    NDEF_ALLOC_FIELD };
+		if (rec->payload && !(rec->borrowed & NDEF_BORROW_PAYLOAD)) pool->fields[pool->fields_len++] = (pool_field) { rec->payload, NDEF_ALLOC_PAYLOAD };
+		if (rec->id      && !(rec->borrowed & NDEF_BORROW_ID))      pool->fields[pool->fields_len++] = (pool_field) { rec->id,      NDEF_ALLOC_FIELD };
+		rec->borrowed = NDEF_BORROW_ALL;
+	}
+	ctx->pool      = pool;
+	ctx->arena     = NULL;
+	ctx->arena_len = 0;
+	ctx->arena_cap = 0;
+	return true;
+}
+
 // Create an empty NDEF codec context.
 ndef_ctx ndef_init() {
+	return ndef_init_alloc(&ndef_default_allocator);
+}
+
+// Create an empty NDEF codec context that keeps its record arrays and arena in memory from `alloc`.
+// Record data other than the arena comes from the global allocator; `alloc` must outlive the context.
+ndef_ctx ndef_init_alloc(const ndef_allocator *alloc) {
+	if (!alloc) alloc = &ndef_default_allocator;
+	
 	// Make new memory.
-	ndef_ctx out = malloc(sizeof(ndef_ctx_s));
+	NDEF_STATS_ALLOC(sizeof(ndef_ctx_s));
+	ndef_ctx out = alloc->alloc(alloc->cookie, sizeof(ndef_ctx_s), NDEF_ALLOC_ARRAY);
 	
 	// Fill with placeholder values.
 	if (out) *out = (ndef_ctx_s) {
-		NDEF_MAGIC,
+		NDEF_MAGIC, alloc,
 		0, 0, NULL,
+		0, NULL,
 		0, 0, NULL,
+		NULL, 0, 0, NULL,
+		0, 0, 0, false,
+		NDEF_OK, 0,
+	};
+	
+	return out;
+}
+
+// Static contexts must fit in their storage.
+_Static_assert(sizeof(ndef_ctx_storage) >= sizeof(ndef_ctx_s), "NDEF_CTX_STORAGE_WORDS is too small for ndef_ctx_s");
+_Static_assert(_Alignof(ndef_ctx_storage) >= _Alignof(ndef_ctx_s), "ndef_ctx_storage is not aligned enough for ndef_ctx_s");
+
+// Allocation functions of static contexts, which always fail.
+static void *no_alloc(void *cookie, size_t size, ndef_alloc_kind kind) {
+	(void) cookie;
+	(void) size;
+	(void) kind;
+	return NULL;
+}
+static void *no_realloc(void *cookie, void *ptr, size_t size, ndef_alloc_kind kind) {
+	(void) cookie;
+	(void) ptr;
+	(void) size;
+	(void) kind;
+	return NULL;
+}
+static void no_free(void *cookie, void *ptr, ndef_alloc_kind kind) {
+	(void) cookie;
+	(void) ptr;
+	(void) kind;
+}
+
+// Allocator of static contexts, which never allocates.
+static const ndef_allocator no_heap_allocator = { no_alloc, no_realloc, no_free, NULL };
+
+// Create an empty NDEF codec context in caller storage that never allocates; see `NDEF_STATIC_CTX`.
+// It holds up to `max_records` raw records; all arrays must have that many entries.
+// Chunked payloads are concatenated and arena decodes are copied into `arena`, which may be NULL.
+// Decoding with `ndef_decode_view_into` or `ndef_decode_arena_into`, moving records in with the `_mv` functions
+// and encoding with `ndef_encode_into` or `ndef_encode_stream` then take time bounded by the data and `max_records`.
+// `ndef_encode_diff` is not available; `ndef_clone` copies the records into a context on the heap.
+ndef_ctx ndef_init_static(ndef_ctx_storage *storage, size_t max_records,
+		ndef_record *records, ndef_enc_entry *enc, ndef_raw_record *raw_cache,
+		uint8_t *arena, size_t arena_len) {
+	if (!storage || !max_records || !records || !enc || !raw_cache) return NULL;
+	if (max_records > NDEF_MAX_RECORDS) max_records = NDEF_MAX_RECORDS;
+	if (!arena) arena_len = 0;
+	
+	ndef_ctx out = (ndef_ctx) storage;
+	*out = (ndef_ctx_s) {
+		NDEF_MAGIC, &no_heap_allocator,
+		0, max_records, enc,
+		max_records, raw_cache,
+		0, max_records, records,
+		arena, 0, arena_len, NULL,
+		0, 0, 0, true,
+		NDEF_OK, 0,
 	};
 	
 	return out;
 }
 
 // Create a clone of an NDEF codec context.
+// The record data is shared between both contexts, so this copies only the record arrays.
+// Ownership of the record data in `ctx` moves to the shared pool, so `ctx` must not be in use elsewhere meanwhile.
 ndef_ctx ndef_clone(ndef_ctx ctx) {
-	MAGIC_CHECK
+	MAGIC_CHECK(NULL)
+	
+	// The storage of static contexts cannot be shared, so their records are copied instead.
+	if (ctx->fixed) {
+		ndef_ctx out = ndef_init();
+		if (!out) return NULL;
+		out->chunk_size = ctx->chunk_size;
+		if (!ndef_append_n(out, 0, ctx->abs_records, ctx->abs_records_len)) {
+			ndef_destroy(out);
+			return NULL;
+		}
+		return out;
+	}
 	
 	// Make new memory.
-	ndef_ctx out = malloc(sizeof(ndef_ctx));
-	if (out) {
-		// Copy values.
-		*out = *ctx;
-		
-		// Clone arrays.
-		out->abs_records = malloc(sizeof(ndef_record) * out->abs_records_cap);
-		memcpy(out->abs_records, ctx->abs_records, sizeof(ndef_record) * out->abs_records_cap);
-		out->raw_records = malloc(sizeof(ndef_raw_record) * out->raw_records_cap);
-		memcpy(out->raw_records, ctx->raw_records, sizeof(ndef_raw_record) * out->raw_records_cap);
+	ndef_ctx out = ndef_init_alloc(ctx->alloc);
+	if (!out) return NULL;
+	out->chunk_size = ctx->chunk_size;
+	out->base_len   = ctx->base_len;
+	if (ctx->abs_records_len) {
+		out->abs_records = ctx_malloc(out, sizeof(ndef_record) * ctx->abs_records_len, NDEF_ALLOC_ARRAY);
+		if (!out->abs_records) {
+			NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", sizeof(ndef_record) * ctx->abs_records_len);
+			ndef_destroy(out);
+			return NULL;
+		}
+		out->abs_records_cap = ctx->abs_records_len;
+	}
+	if (!enc_reserve(out, ctx->enc_len) || !pool_share(ctx)) {
+		ndef_destroy(out);
+		return NULL;
 	}
 	
+	// Copy the records and encoding details, which now borrow from the shared pool.
+	if (ctx->abs_records_len) memcpy(out->abs_records, ctx->abs_records, sizeof(ndef_record) * ctx->abs_records_len);
+	if (ctx->enc_len)         memcpy(out->enc,         ctx->enc,         sizeof(ndef_enc_entry) * ctx->enc_len);
+	out->abs_records_len = ctx->abs_records_len;
+	out->enc_len         = ctx->enc_len;
+	out->pool            = ctx->pool;
+	if (out->pool) atomic_fetch_add(&out->pool->refcount, 1);
+	
 	return out;
 }
 
 // Destroy an NDEF codec context.
 void ndef_destroy(ndef_ctx ctx) {
+	MAGIC_CHECK()
 	ndef_clear(ctx);
 	ctx->magic = 0;
+	ctx_free(ctx, ctx, NDEF_ALLOC_ARRAY);
 }
 
 
-// Print a hierarchical info about this NDEF record.
-static void ndef_record_print_info_r(ndef_record ctx, size_t recursion_limit, size_t indent);
-// Print a hierarchical info about this NDEF message.
-static void ndef_print_info_r(ndef_ctx ctx, size_t recursion_limit, size_t indent);
+// Ways in which `decode` can store record data.
+typedef enum {
+	// Every field is copied into its own allocation.
+	DECODE_COPY,
+	// Fields point into the input data.
+	DECODE_VIEW,
+	// Fields are copied into the context's arena.
+	DECODE_ARENA,
+} decode_mode;
 
-// Print a hierarchical info about this NDEF record.
-static void ndef_record_print_info_r(ndef_record ctx, size_t recursion_limit, size_t indent) {
-	// Check recursion limit.
-	if (!recursion_limit) {
-		for (int x = 0; x < indent; x++) putc(' ', stdout);
-		printf("(recursion limited)\n");
-		return;
-	}
-	
-	// Check empty record.
-	if ((!ctx.id_len && !ctx.payload_len && !ctx.type_len) || ctx.tnf == NDEF_TNF_EMPTY) {
-		for (int x = 0; x < indent; x++) putc(' ', stdout);
-		printf("(empty record)\n");
-	} else {
-		for (int x = 0; x < indent; x++) putc(' ', stdout);
-		printf("NDEF record:\n");
-		indent += 2;
-	}
+// Check that a blob of NDEF data is a well-formed message without allocating any memory.
+// If `info` is not NULL, it is filled in with the sizes of the contents.
+ndef_err ndef_validate(const uint8_t *data, size_t len, ndef_validate_info *info) {
+	ndef_validate_info cur  = { 0 };
+	ndef_validate_info done = { 0 };
+	ndef_err err         = NDEF_OK;
+	size_t   pos         = 0;
+	size_t   payload_len = 0;
+	bool     in_chunk    = false;
+	bool     end         = false;
 	
-	// ID field.
-	if (ctx.id_len) {
-		for (int x = 0; x < indent; x++) putc(' ', stdout);
-		printf("ID:    %zu byte", ctx.id_len);
-		if (ctx.id_len <= 16) {
-			if (ctx.id_len != 1) putc('s', stdout);
-			hexdump(ctx.id, ctx.id_len, 2);
-			
-		} else /* ctx.id_len > 16 */ {
-			printf("s:\n");
-			hexdump(ctx.id, ctx.id_len, indent + 2);
+	while (!end) {
+		// Record header.
+		size_t  avail = len - pos;
+		if (!avail) { err = NDEF_ERR_TRUNCATED; break; }
+		uint8_t flags = data[pos];
+		size_t  hlen  = 2 + (flags & NDEF_FLAG_SR ? 1 : 4) + (flags & NDEF_FLAG_IL ? 1 : 0);
+		if (avail < hlen) { err = NDEF_ERR_TRUNCATED; break; }
+		
+		// Field lengths.
+		const uint8_t *hdr = data + pos + 1;
+		size_t type_len = *hdr++;
+		size_t rec_payload_len;
+		if (flags & NDEF_FLAG_SR) {
+			rec_payload_len = *hdr++;
+		} else {
+			rec_payload_len  = (size_t) hdr[0] << 24;
+			rec_payload_len |= (size_t) hdr[1] << 16;
+			rec_payload_len |= (size_t) hdr[2] <<  8;
+			rec_payload_len |= (size_t) hdr[3] <<  0;
+			hdr += 4;
+		}
+		size_t id_len = flags & NDEF_FLAG_IL ? *hdr : 0;
+		if (rec_payload_len > avail - hlen || type_len + id_len > avail - hlen - rec_payload_len) {
+			err = NDEF_ERR_TRUNCATED;
+			break;
+		}
+		
+		// Only the first record may begin the message.
+		bool begin = flags & NDEF_FLAG_MB;
+		if (begin != !cur.raw_records) { err = NDEF_ERR_FLAGS; break; }
+		
+		// Only chunks after the first may use the UNCHANGED type, and they have no type or ID.
+		uint8_t tnf = flags & NDEF_FLAG_TNF;
+		if (in_chunk ? tnf != NDEF_TNF_UNCHANGED || type_len || (flags & NDEF_FLAG_IL) : tnf == NDEF_TNF_UNCHANGED) {
+			err = NDEF_ERR_CHUNK;
+			break;
 		}
+		// The message cannot end in the middle of a chunked record.
+		if ((flags & NDEF_FLAG_ME) && (flags & NDEF_FLAG_CF)) { err = NDEF_ERR_CHUNK; break; }
 		
+		// Limits of the record representation.
+		if (!in_chunk) payload_len = 0;
+		if (cur.raw_records >= NDEF_MAX_RECORDS || NDEF_MAX_PAYLOAD - payload_len < rec_payload_len) {
+			err = NDEF_ERR_TOO_LONG;
+			break;
+		}
+		payload_len += rec_payload_len;
+		
+		// Tally the record.
+		cur.raw_records   ++;
+		cur.records       += !in_chunk;
+		cur.type_bytes    += type_len;
+		cur.payload_bytes += rec_payload_len;
+		cur.id_bytes      += id_len;
+		pos               += hlen + type_len + rec_payload_len + id_len;
+		cur.encoded_len    = pos;
+		in_chunk           = flags & NDEF_FLAG_CF;
+		end                = flags & NDEF_FLAG_ME;
+		if (!in_chunk) done = cur;
 	}
 	
-	// Type field.
-	if (ctx.type_len) {
-		for (int x = 0; x < indent; x++) putc(' ', stdout);
-		printf("Type:  %zu byte", ctx.type_len);
-		if (ctx.type_len <= 16) {
-			if (ctx.type_len != 1) putc('s', stdout);
-			hexdump(ctx.type, ctx.type_len, 2);
-			
-		} else /* ctx.type_len > 16 */ {
-			printf("s:\n");
-			hexdump(ctx.type, ctx.type_len, indent + 2);
+	// Describe the complete records before the error, if any.
+	done.error        = err;
+	done.error_offset = err ? pos : 0;
+	if (info) *info = done;
+	return err;
+}
+
+// Make sure the context has capacity for at least `raw_cap` raw and `abs_cap` abstract records.
+static bool reserve(ndef_ctx ctx, size_t raw_cap, size_t abs_cap) {
+	if (!enc_reserve(ctx, raw_cap)) return false;
+	if (abs_cap > NDEF_MAX_RECORDS) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Too many records (%zu; maximum is %zu)", abs_cap, (size_t) NDEF_MAX_RECORDS);
+		return fail(ctx, NDEF_ERR_TOO_LONG, 0);
+	}
+	if (abs_cap > ctx->abs_records_cap) {
+		if (ctx->fixed) return fixed_full(ctx, abs_cap, ctx->abs_records_cap);
+		void *mem = ctx_realloc(ctx, ctx->abs_records, sizeof(ndef_record) * abs_cap, NDEF_ALLOC_ARRAY);
+		if (!mem) {
+			NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", sizeof(ndef_record) * abs_cap);
+			return fail(ctx, NDEF_ERR_NO_MEM, 0);
 		}
-		
+		ctx->abs_records     = mem;
+		ctx->abs_records_cap = abs_cap;
+	}
+	return true;
+}
+
+// Allocate `len` bytes from the context's arena.
+static uint8_t *arena_alloc(ndef_ctx ctx, size_t len) {
+	if (!len) return NULL;
+	if (ctx->arena_cap - ctx->arena_len < len) return NULL;
+	uint8_t *mem = ctx->arena + ctx->arena_len;
+	ctx->arena_len += len;
+	return mem;
+}
+
+// Copy `len` bytes of `data` into the context's arena.
+static uint8_t *arena_dup(ndef_ctx ctx, const uint8_t *data, size_t len) {
+	uint8_t *mem = arena_alloc(ctx, len);
+	if (mem) memcpy(mem, data, len);
+	return mem;
+}
+
+// Copy `len` bytes of `data` into a new allocation.
+static uint8_t *heap_dup(const uint8_t *data, size_t len, ndef_alloc_kind kind) {
+	if (!len) return NULL;
+	uint8_t *mem = ndef_malloc(len, kind);
+	if (!mem) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", len);
+		return NULL;
 	}
+	memcpy(mem, data, len);
+	return mem;
+}
+
+// A sequence of one or more raw records that make up a single abstract record.
+typedef struct {
+	// First raw record, with the type and ID.
+	ndef_raw_record first;
+	// Number of raw records.
+	size_t   count;
+	// Encoded length of the raw records.
+	size_t   len;
+	// Total payload length.
+	size_t   payload_len;
+	// Number of raw records with a non-empty payload.
+	size_t   non_empty;
+	// Payload of the last raw record with a non-empty payload.
+	uint8_t *payload;
+} record_seq;
+
+// Find the raw records that make up the abstract record at the start of `data`.
+// If they do not form a valid chunk sequence, `seq->len` is set to the offset of the offending raw record.
+static ndef_err next_record(uint8_t *data, size_t len, record_seq *seq) {
+	*seq = (record_seq) { 0 };
 	
-	// Check type.
-	bool do_hexdump = false;
-	if (ndef_record_is_smartposter(ctx)) {
-		// Smart poster type.
-		for (int x = 0; x < indent; x++) putc(' ', stdout);
-		printf("Note:  Record is smart poster\n");
-		
-		// Try to show smart poster info.
-		ndef_smartposter sp = ndef_record_get_smartposter(ctx);
-		if (!sp.uri && !sp.text.lang) {
-			do_hexdump = true;
-		} else {
-			ndef_print_info_r(sp.ndef, recursion_limit - 1, indent);
+	size_t pos = 0;
+	bool   more;
+	do {
+		ndef_raw_record raw;
+		size_t raw_len = len - pos;
+		seq->len = pos;
+		if (!ndef_raw_record_decode_view(&raw, data + pos, &raw_len)) {
+			if (!seq->count) return NDEF_ERR_TRUNCATED;
+			NDEF_LOG(NDEF_LOG_ERROR, "Decode error: Unterminated chunked record");
+			return NDEF_ERR_CHUNK;
 		}
-		ndef_smartposter_destroy(sp);
 		
-	} else if (ndef_record_is_uri(ctx)) {
-		// URI type.
-		for (int x = 0; x < indent; x++) putc(' ', stdout);
-		printf("Note:  Record is URI\n");
-		
-		// Try to show URI.
-		char *uri = ndef_record_get_uri(ctx);
-		if (uri) {
-			for (int x = 0; x < indent; x++) putc(' ', stdout);
-			printf("URI:   %s\n", uri);
-			free(uri);
-		} else {
-			do_hexdump = true;
+		// Only chunks after the first may use the UNCHANGED type.
+		if (!seq->count && raw.tnf == NDEF_TNF_UNCHANGED) {
+			NDEF_LOG(NDEF_LOG_ERROR, "Decode error: Unexpected UNCHANGED record");
+			return NDEF_ERR_CHUNK;
+		} else if (seq->count && (raw.tnf != NDEF_TNF_UNCHANGED || raw.type_len || raw.flag_include_id_len)) {
+			NDEF_LOG(NDEF_LOG_ERROR, "Decode error: Invalid middle or terminating chunk");
+			return NDEF_ERR_CHUNK;
 		}
 		
-	} else if (ndef_record_is_text(ctx)) {
-		// Text type.
-		for (int x = 0; x < indent; x++) putc(' ', stdout);
-		printf("Note:  Record is text\n");
-		
-		// Try to show text.
-		ndef_text text = ndef_record_get_text(ctx);
-		if (text.lang) {
-			for (int x = 0; x < indent; x++) putc(' ', stdout);
-			printf("Lang:  %s\n", text.lang);
-			for (int x = 0; x < indent; x++) putc(' ', stdout);
-			printf("Text:  %s\n", text.text);
-			
-		} else {
-			do_hexdump = true;
-		}
-		ndef_text_destroy(text);
-	}
-	
-	if (do_hexdump) {
-		// Default: Simple info dump.
-		if (ctx.payload_len) {
-			for (int x = 0; x < indent; x++) putc(' ', stdout);
-			printf("Payload: %zu byte", ctx.payload_len);
-			if (ctx.payload_len <= 16) {
-				if (ctx.payload_len != 1) putc('s', stdout);
-				hexdump(ctx.payload, ctx.payload_len, 2);
-				
-			} else /* ctx.payload_len > 16 */ {
-				printf("s:\n");
-				hexdump(ctx.payload, ctx.payload_len, indent + 2);
+		if (!seq->count) seq->first = raw;
+		if (raw.payload_len) {
+			if (NDEF_MAX_PAYLOAD - seq->payload_len < raw.payload_len) {
+				NDEF_LOG(NDEF_LOG_ERROR, "Decode error: Chunked record too long");
+				return NDEF_ERR_TOO_LONG;
 			}
-			
-		} else {
-			for (int x = 0; x < indent; x++) putc(' ', stdout);
-			printf("Payload: empty\n");
+			seq->payload_len += raw.payload_len;
+			seq->payload      = raw.payload;
+			seq->non_empty   ++;
 		}
-	}
+		seq->count ++;
+		pos  += raw_len;
+		more  = raw.flag_chunked;
+	} while (more);
+	
+	seq->len = pos;
+	return NDEF_OK;
 }
 
-// Print a hierarchical info about this NDEF message.
-static void ndef_print_info_r(ndef_ctx ctx, size_t recursion_limit, size_t indent) {
-	// Check recursion limit.
-	if (!recursion_limit) {
-		for (int x = 0; x < indent; x++) putc(' ', stdout);
-		printf("(recursion limited)\n");
-		return;
-	}
+// Store the abstract record made by the raw records `seq` found at the start of `data`.
+// Every field is stored exactly once; the raw records only get encoding details.
+static bool append_decoded(ndef_ctx ctx, uint8_t *data, size_t enc_offset, const record_seq *seq, decode_mode mode) {
+	ndef_record record = seq->first.abstract;
+	record.payload_len = seq->payload_len;
+	record.payload     = seq->payload;
+	bool concat        = seq->non_empty > 1;
+	NDEF_PHASE_BEGIN(NDEF_PHASE_COPY);
 	
-	// Print number of records.
-	for (int x = 0; x < indent; x++) putc(' ', stdout);
-	if (ctx->abs_records_len) {
-		printf("NDEF message: %zu record%s", ctx->abs_records_len, ctx->abs_records_len == 1 ? "\n" : "s\n");
+	// Store the type and ID.
+	if (mode == DECODE_COPY) {
+		record.borrowed = 0;
+		record.type     = heap_dup(seq->first.type, record.type_len, NDEF_ALLOC_FIELD);
+		record.id       = heap_dup(seq->first.id,   record.id_len,   NDEF_ALLOC_FIELD);
+		if ((record.type_len && !record.type) || (record.id_len && !record.id)) {
+			NDEF_PHASE_END(NDEF_PHASE_COPY);
+			record.payload = NULL;
+			ndef_record_destroy(record);
+			return fail(ctx, NDEF_ERR_NO_MEM, 0);
+		}
+	} else if (mode == DECODE_ARENA) {
+		record.borrowed = NDEF_BORROW_ALL;
+		record.type     = arena_dup(ctx, seq->first.type, record.type_len);
+		record.id       = arena_dup(ctx, seq->first.id,   record.id_len);
 	} else {
-		printf("NDEF message: empty\n");
+		// Only a concatenated payload is owned by view records, except in static contexts, which use the arena.
+		record.borrowed = concat && !ctx->fixed ? NDEF_BORROW_TYPE | NDEF_BORROW_ID : NDEF_BORROW_ALL;
 	}
 	
-	// Do the print on EACH ONE.
-	for (size_t i = 0; i < ctx->abs_records_len; i++) {
-		ndef_record_print_info_r(ctx->abs_records[i], recursion_limit-1, indent + 2);
+	// Store the payload, concatenating chunks if more than one has data.
+	if (concat) {
+		record.payload = mode == DECODE_ARENA || ctx->fixed ? arena_alloc(ctx, seq->payload_len) : ndef_malloc(seq->payload_len, NDEF_ALLOC_PAYLOAD);
+	} else if (mode == DECODE_COPY) {
+		record.payload = heap_dup(seq->payload, seq->payload_len, NDEF_ALLOC_PAYLOAD);
+	} else if (mode == DECODE_ARENA) {
+		record.payload = arena_dup(ctx, seq->payload, seq->payload_len);
+	}
+	if (record.payload_len && !record.payload) {
+		NDEF_PHASE_END(NDEF_PHASE_COPY);
+		if (concat) NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", seq->payload_len);
+		ndef_record_destroy(record);
+		return fail(ctx, NDEF_ERR_NO_MEM, 0);
+	}
+	
+	// Make room for the encoding details.
+	if (!enc_reserve(ctx, ctx->enc_len + seq->count)) {
+		NDEF_PHASE_END(NDEF_PHASE_COPY);
+		ndef_record_destroy(record);
+		return false;
 	}
+	
+	// Copy the chunks while noting down how they were encoded.
+	size_t abs_index = ctx->abs_records_len;
+	size_t pos = 0, offset = 0;
+	for (size_t i = 0; i < seq->count; i++) {
+		ndef_raw_record raw;
+		size_t raw_len = seq->len - pos;
+		if (!ndef_raw_record_decode_view(&raw, data + pos, &raw_len)) {
+			// Can't happen after `next_record` has checked the data, but don't trust it blindly.
+			NDEF_PHASE_END(NDEF_PHASE_COPY);
+			ndef_record_destroy(record);
+			return fail(ctx, NDEF_ERR_TRUNCATED, enc_offset + pos);
+		}
+		
+		if (concat && raw.payload_len) memcpy(record.payload + offset, raw.payload, raw.payload_len);
+		raw.abs_index = abs_index;
+		ctx->enc[ctx->enc_len + i] = (ndef_enc_entry) {
+			.detail         = raw.enc_detail,
+			.payload_offset = offset,
+			.payload_len    = raw.payload_len,
+			.enc_offset     = enc_offset + pos,
+		};
+		pos += raw_len;
+		offset += raw.payload_len;
+	}
+	NDEF_PHASE_END(NDEF_PHASE_COPY);
+	
+	// Append the abstract record and link it to the raw records.
+	if (!ndef_append_mv(ctx, record)) {
+		ndef_record_destroy(record);
+		return false;
+	}
+	ctx->abs_records[abs_index].raw_index = ctx->enc_len;
+	ctx->abs_records[abs_index].raw_len   = seq->count;
+	ctx->enc_len += seq->count;
+	
+	return true;
 }
 
-// Print a hierarchical info about this NDEF message.
-void ndef_print_info(ndef_ctx ctx) {
-	ndef_print_info_r(ctx, 8, 0);
+// Common NDEF blob decoder; replaces the records in `ctx`.
+// Returns true if all of `data` was decoded.
+static bool decode_into(ndef_ctx ctx, uint8_t *data, size_t *len, decode_mode mode) {
+	// Start from an empty message, keeping the memory.
+	ndef_reset(ctx);
+	
+	// Size everything up front so the arrays and arena are allocated at most once.
+	ndef_validate_info info;
+	NDEF_PHASE_BEGIN(NDEF_PHASE_VALIDATE);
+	ndef_err invalid = ndef_validate(data, *len, &info);
+	NDEF_PHASE_END(NDEF_PHASE_VALIDATE);
+	if (invalid) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Decode error: Invalid message (%s at offset %zu)", ndef_err_names[info.error], info.error_offset);
+		fail(ctx, info.error, info.error_offset);
+	}
+	size_t decode_len = info.encoded_len;
+	size_t bytes      = info.type_bytes + info.payload_bytes + info.id_bytes;
+	NDEF_PHASE_BEGIN(NDEF_PHASE_RESERVE);
+	bool reserved = reserve(ctx, info.raw_records, info.records);
+	NDEF_PHASE_END(NDEF_PHASE_RESERVE);
+	if (!reserved) {
+		*len = 0;
+		return false;
+	}
+	if (mode == DECODE_ARENA && bytes > ctx->arena_cap && ctx->fixed) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Not enough space in arena (%zu bytes; expected %zu bytes)", ctx->arena_cap, bytes);
+		*len = 0;
+		return fail(ctx, NDEF_ERR_NO_SPACE, 0);
+	} else if (mode == DECODE_ARENA && bytes > ctx->arena_cap) {
+		// Nothing in the arena is in use after the reset.
+		NDEF_PHASE_BEGIN(NDEF_PHASE_RESERVE);
+		if (ctx->arena) ctx_free(ctx, ctx->arena, NDEF_ALLOC_ARENA);
+		ctx->arena     = ctx_malloc(ctx, bytes, NDEF_ALLOC_ARENA);
+		ctx->arena_cap = ctx->arena ? bytes : 0;
+		NDEF_PHASE_END(NDEF_PHASE_RESERVE);
+		if (!ctx->arena) {
+			NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", bytes);
+			*len = 0;
+			return fail(ctx, NDEF_ERR_NO_MEM, 0);
+		}
+	}
+	
+	// Continuous parsing time!
+	size_t pos = 0;
+	while (decode_len > pos) {
+		// Find the raw records of one abstract record.
+		record_seq seq;
+		NDEF_PHASE_BEGIN(NDEF_PHASE_HEADER);
+		ndef_err   res = next_record(data + pos, decode_len - pos, &seq);
+		NDEF_PHASE_END(NDEF_PHASE_HEADER);
+		if (res) { fail(ctx, res, pos + seq.len); break; }
+		
+		// Store it.
+		if (!append_decoded(ctx, data + pos, pos, &seq, mode)) { ctx->error_offset = pos; break; }
+		pos += seq.len;
+	}
+	
+	// What was decoded is the baseline for `ndef_encode_diff`.
+	ctx->base_len = pos;
+	
+	if (ctx->error) {
+		NDEF_LOG(NDEF_LOG_NOTE, "Note: Decoding is partial");
+	}
+	*len = pos;
+	return !ctx->error;
 }
 
-
-// Decode a blob of NDEF data.
-ndef_ctx ndef_decode(uint8_t *data, size_t *len) {
-	bool partial = false;
-	
+// Common NDEF blob decoder.
+static ndef_ctx decode(uint8_t *data, size_t *len, decode_mode mode) {
 	// NULL checks.
 	if (!data || !len || !*len) return NULL;
 	
 	// Make a context for APPENDING to.
 	ndef_ctx ctx = ndef_init();
+	if (!ctx) return NULL;
 	
-	// Continuous parsing time!
-	size_t pos = 0;
-	while (*len > pos) {
-		// Decode one record.
-		ndef_raw_record record;
-		size_t record_len = *len - pos;
-		bool res = ndef_raw_record_decode(&record, data + pos, &record_len);
-		if (!res) { partial = true; break; }
-		pos += record_len;
-		
-		// Append raw record.
-		res = ndef_raw_append(ctx, record);
-		if (!res) { partial = true; break; }
-	}
+	decode_into(ctx, data, len, mode);
+	return ctx;
+}
+
+// Decode a blob of NDEF data.
+ndef_ctx ndef_decode(uint8_t *data, size_t *len) {
+	return decode(data, len, DECODE_COPY);
+}
+
+// Decode a blob of NDEF data without copying it.
+// The `type`, `payload` and `id` of the records point into `data`, which must outlive the context.
+ndef_ctx ndef_decode_view(uint8_t *data, size_t *len) {
+	return decode(data, len, DECODE_VIEW);
+}
+
+// Decode a blob of NDEF data into a single allocation owned by the context.
+ndef_ctx ndef_decode_arena(uint8_t *data, size_t *len) {
+	return decode(data, len, DECODE_ARENA);
+}
+
+// Decode a blob of NDEF data, replacing the records in an existing context.
+// Returns true if all of `data` was decoded; `len` is set to the amount of successfully decoded data.
+bool ndef_decode_into(ndef_ctx ctx, uint8_t *data, size_t *len) {
+	MAGIC_CHECK(false)
+	if (!data || !len) return false;
+	return decode_into(ctx, data, len, DECODE_COPY);
+}
+
+// Decode a blob of NDEF data without copying it, replacing the records in an existing context.
+// Returns true if all of `data` was decoded; `len` is set to the amount of successfully decoded data.
+bool ndef_decode_view_into(ndef_ctx ctx, uint8_t *data, size_t *len) {
+	MAGIC_CHECK(false)
+	if (!data || !len) return false;
+	return decode_into(ctx, data, len, DECODE_VIEW);
+}
+
+// Decode a blob of NDEF data into the context's arena, replacing the records in an existing context.
+// Returns true if all of `data` was decoded; `len` is set to the amount of successfully decoded data.
+bool ndef_decode_arena_into(ndef_ctx ctx, uint8_t *data, size_t *len) {
+	MAGIC_CHECK(false)
+	if (!data || !len) return false;
+	return decode_into(ctx, data, len, DECODE_ARENA);
+}
+
+// Determine the number of chunks used to encode abstract record `index`.
+size_t ndef_enc_chunk_count(ndef_ctx ctx, size_t index) {
+	size_t payload_len = ctx->abs_records[index].payload_len;
+	if (!ctx->chunk_size || payload_len <= ctx->chunk_size) return 1;
+	return (payload_len + ctx->chunk_size - 1) / ctx->chunk_size;
+}
+
+// Make the raw record used to encode chunk `chunk` of `chunks` of abstract record `index`.
+ndef_raw_record ndef_make_raw(ndef_ctx ctx, size_t index, size_t chunk, size_t chunks) {
+	// Make a raw record.
+	ndef_raw_record raw = { .raw_index = index, .raw_len = 0, .abs_index = index };
+	raw.abstract = ctx->abs_records[index];
 	
-	// Decode raw records into full records.
-	for (size_t i = 0; i < ctx->raw_records_len; i++) {
-		// TODO: Support for chunked records.
-		ctx->raw_records[i].abs_index = i;
-		ctx->raw_records[i].raw_index = i;
-		ctx->raw_records[i].raw_len   = 1;
-		ndef_append(ctx, ctx->raw_records[i].abstract);
+	// Select this chunk's part of the payload.
+	if (chunks > 1) {
+		size_t offset   = chunk * ctx->chunk_size;
+		raw.payload     = raw.payload + offset;
+		raw.payload_len = chunk == chunks - 1 ? raw.payload_len - offset : ctx->chunk_size;
+		if (chunk) {
+			// Only the first chunk has type and ID.
+			raw.tnf      = NDEF_TNF_UNCHANGED;
+			raw.type_len = 0;
+			raw.type     = NULL;
+			raw.id_len   = 0;
+			raw.id       = NULL;
+		}
 	}
 	
-	if (partial) {
-		printf("NDEF: Note: Decoding is partial\n");
+	// Think up some flags for it.
+	raw.flag_begin			= index == 0 && chunk == 0;
+	raw.flag_end			= index == ctx->abs_records_len - 1 && chunk == chunks - 1;
+	raw.flag_chunked		= chunk < chunks - 1;
+	raw.flag_short_record	= !(raw.payload_len & 0xffffff00);
+	raw.flag_include_id_len	= raw.id_len;
+	return raw;
+}
+
+// Encode all records into an output stream.
+// The raw records and the baseline of `ndef_encode_diff` are left alone.
+static bool encode(ndef_ctx ctx, ndef_ostream *out) {
+	ctx->error        = NDEF_OK;
+	ctx->error_offset = 0;
+	NDEF_PHASE_BEGIN(NDEF_PHASE_ENCODE);
+	size_t pos = 0;
+	for (size_t i = 0; i < ctx->abs_records_len; i++) {
+		size_t chunks = ndef_enc_chunk_count(ctx, i);
+		for (size_t x = 0; x < chunks; x++) {
+			ndef_raw_record raw = ndef_make_raw(ctx, i, x, chunks);
+			if (!ndef_raw_record_encode(out, &raw)) {
+				NDEF_PHASE_END(NDEF_PHASE_ENCODE);
+				return fail(ctx, out->error, pos);
+			}
+			pos += ndef_raw_record_size(&raw);
+		}
 	}
-	return ctx;
+	NDEF_PHASE_END(NDEF_PHASE_ENCODE);
+	return true;
 }
 
 // Encode the NDEF data into a new blob.
 bool ndef_encode(ndef_ctx ctx, uint8_t **out_data, size_t *out_len) {
-	MAGIC_CHECK
+	MAGIC_CHECK(false)
 	
-	// Make stream to output to.
+	// Make stream to output to, sized exactly for the message.
 	ndef_ostream out = ndef_ostream_init();
+	size_t len = ndef_encode_size(ctx);
+	NDEF_PHASE_BEGIN(NDEF_PHASE_RESERVE);
+	bool reserved = ndef_ostream_reserve(&out, len);
+	NDEF_PHASE_END(NDEF_PHASE_RESERVE);
+	if (!reserved) return fail(ctx, out.error, 0);
 	
 	// Add some chunks.
-	ndef_raw_clear(ctx);
-	for (size_t i = 0; i < ctx->abs_records_len; i++) {
-		// Make a raw record.
-		ndef_raw_record raw = { .raw_index = i, .raw_len = 0, .abs_index = i };
-		// Think up some flags for it.
-		raw.abstract			= ctx->abs_records[i];
-		raw.flag_begin			= i == 0;
-		raw.flag_end			= i == ctx->abs_records_len - 1;
-		raw.flag_chunked		= false;
-		raw.flag_short_record	= !(raw.payload_len & 0xffffff00);
-		raw.flag_include_id_len	= raw.id_len;
-		// Write out the data.
-		bool res = ndef_raw_record_encode(&out, &raw);
-		if (!res) {
-			ndef_ostream_destroy(out);
-			return false;
-		}
+	if (!encode(ctx, &out)) {
+		ndef_ostream_destroy(out);
+		return false;
 	}
 	
 	// Output the final data.
@@ -630,26 +1295,269 @@ bool ndef_encode(ndef_ctx ctx, uint8_t **out_data, size_t *out_len) {
 	return true;
 }
 
+// Determine the exact size of the blob `ndef_encode` would produce.
+size_t ndef_encode_size(ndef_ctx ctx) {
+	MAGIC_CHECK(0)
+	
+	size_t len = 0;
+	for (size_t i = 0; i < ctx->abs_records_len; i++) {
+		size_t chunks = ndef_enc_chunk_count(ctx, i);
+		for (size_t x = 0; x < chunks; x++) {
+			ndef_raw_record raw = ndef_make_raw(ctx, i, x, chunks);
+			len += ndef_raw_record_size(&raw);
+		}
+	}
+	return len;
+}
+
+// Set the maximum payload size of a raw record when encoding.
+// Larger payloads are split into chunked records; 0 disables chunking.
+void ndef_set_chunk_size(ndef_ctx ctx, size_t chunk_size) {
+	MAGIC_CHECK()
+	if (chunk_size != ctx->chunk_size) ctx->generation ++;
+	ctx->chunk_size = chunk_size;
+}
+
+// Get a number that changes every time the records or the chunk size change, and thus the output of `ndef_encode`.
+uint32_t ndef_get_generation(ndef_ctx ctx) {
+	MAGIC_CHECK(0)
+	return ctx->generation;
+}
+
+// Get the reason the last decode, encode or insertion on this context failed, or `NDEF_OK`.
+// If not NULL, `offset` is set to where in the data it failed.
+ndef_err ndef_get_error(ndef_ctx ctx, size_t *offset) {
+	MAGIC_CHECK(NDEF_ERR_INVALID)
+	if (offset) *offset = ctx->error_offset;
+	return ctx->error;
+}
+
+// Encode the NDEF data into a caller-provided buffer of `cap` bytes.
+bool ndef_encode_into(ndef_ctx ctx, uint8_t *buf, size_t cap, size_t *out_len) {
+	MAGIC_CHECK(false)
+	
+	ndef_ostream out = ndef_ostream_init_fixed(buf, cap);
+	if (!encode(ctx, &out)) return false;
+	
+	*out_len = out.buf_len;
+	return true;
+}
+
+// Encode the NDEF data, passing it to `write` as it is produced.
+bool ndef_encode_stream(ndef_ctx ctx, ndef_write_cb write, void *cookie, uint8_t *batch, size_t batch_len) {
+	MAGIC_CHECK(false)
+	
+	ndef_ostream out = ndef_ostream_init_sink(write, cookie, batch, batch_len);
+	if (!encode(ctx, &out)) return false;
+	size_t staged = out.buf_len;
+	if (!ndef_ostream_flush(&out)) return fail(ctx, out.error, ndef_encode_size(ctx) - staged);
+	return true;
+}
+
+
+// Reconstruct the raw record described by an encoding entry.
+// The raw record borrows its part of the abstract record; only the `first` chunk has type and ID.
+static ndef_raw_record entry_raw(ndef_ctx ctx, const ndef_enc_entry *entry, bool first) {
+	const ndef_record *abs = ctx->abs_records + entry->detail.abs_index;
+	ndef_raw_record    raw;
+	raw.abstract    = *abs;
+	raw.enc_detail  = entry->detail;
+	raw.borrowed    = NDEF_BORROW_ALL;
+	raw.payload_len = entry->payload_len;
+	raw.payload     = abs->payload && entry->payload_len ? abs->payload + entry->payload_offset : NULL;
+	if (!first) {
+		raw.tnf      = NDEF_TNF_UNCHANGED;
+		raw.kind     = 0;
+		raw.type_len = 0;
+		raw.type     = NULL;
+		raw.id_len   = 0;
+		raw.id       = NULL;
+	}
+	return raw;
+}
+
+// Add `len` changed bytes at `offset` to a list of page-aligned ranges, merging it with the previous range.
+static void add_range(ndef_range *ranges, size_t *ranges_len, size_t offset, size_t len, size_t page_size, size_t page_offset) {
+	// Widen to whole pages, which may start before the message.
+	size_t start = page_offset + offset;
+	size_t end   = start + len;
+	start -= start % page_size;
+	end   += (page_size - end % page_size) % page_size;
+	start  = start > page_offset ? start - page_offset : 0;
+	end   -= page_offset;
+	
+	if (*ranges_len && start <= ranges[*ranges_len - 1].offset + ranges[*ranges_len - 1].len) {
+		ndef_range *prev = ranges + *ranges_len - 1;
+		if (end > prev->offset + prev->len) prev->len = end - prev->offset;
+	} else {
+		ranges[(*ranges_len)++] = (ndef_range) { start, end - start };
+	}
+}
+
+// Encode the NDEF data like `ndef_encode`, but keep the layout of records that have raw records,
+// and find the byte ranges that differ from the baseline: the data last decoded or diffed against.
+// The ranges are widened to pages of `page_size` bytes, where the message starts `page_offset` bytes into a page,
+// and clipped to the message; free `*ranges` with `ndef_free`. The new encoding becomes the baseline.
+// If the length changed, the caller must also update the length in the TLV or NLEN.
+bool ndef_encode_diff(ndef_ctx ctx, size_t page_size, size_t page_offset,
+		uint8_t **out_data, size_t *out_len, ndef_range **ranges, size_t *ranges_len) {
+	MAGIC_CHECK(false)
+	if (ctx->fixed) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: ndef_encode_diff is not available on static contexts");
+		return fail(ctx, NDEF_ERR_INVALID, 0);
+	}
+	ctx->error        = NDEF_OK;
+	ctx->error_offset = 0;
+	if (!page_size) page_size = 1;
+	page_offset %= page_size;
+	
+	// Records with raw records keep them; the others are chunked anew.
+	size_t count = 0;
+	for (size_t i = 0; i < ctx->abs_records_len; i++) {
+		size_t raw_len = ctx->abs_records[i].raw_len;
+		count += raw_len ? raw_len : ndef_enc_chunk_count(ctx, i);
+	}
+	if (count > NDEF_MAX_RECORDS) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Too many records (%zu; maximum is %zu)", count, (size_t) NDEF_MAX_RECORDS);
+		return fail(ctx, NDEF_ERR_TOO_LONG, 0);
+	}
+	ndef_enc_entry *plan  = count ? ctx_malloc(ctx, sizeof(ndef_enc_entry) * count, NDEF_ALLOC_ARRAY) : NULL;
+	ndef_range     *diffs = ndef_malloc(sizeof(ndef_range) * (count ? count : 1), NDEF_ALLOC_OUTPUT);
+	if ((count && !plan) || !diffs) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", (sizeof(ndef_enc_entry) + sizeof(ndef_range)) * count);
+		if (plan) ctx_free(ctx, plan, NDEF_ALLOC_ARRAY);
+		ndef_free(diffs, NDEF_ALLOC_OUTPUT);
+		return fail(ctx, NDEF_ERR_NO_MEM, 0);
+	}
+	
+	// Lay out the raw records, noting down which bytes differ from the baseline.
+	size_t len = 0, n = 0, diffs_len = 0;
+	for (size_t i = 0; i < ctx->abs_records_len; i++) {
+		const ndef_record *abs = ctx->abs_records + i;
+		size_t chunks = abs->raw_len ? abs->raw_len : ndef_enc_chunk_count(ctx, i);
+		for (size_t x = 0; x < chunks; x++) {
+			ndef_enc_entry entry;
+			if (abs->raw_len) {
+				entry = ctx->enc[abs->raw_index + x];
+			} else {
+				ndef_raw_record raw = ndef_make_raw(ctx, i, x, chunks);
+				entry = (ndef_enc_entry) {
+					.detail         = raw.enc_detail,
+					.payload_offset = chunks > 1 ? x * ctx->chunk_size : 0,
+					.payload_len    = raw.payload_len,
+					.enc_offset     = NO_OFFSET,
+				};
+			}
+			bool begin = i == 0 && x == 0;
+			bool end   = i == ctx->abs_records_len - 1 && x == chunks - 1;
+			
+			// Unmoved raw records are unchanged, except maybe for the MB and ME flags in the first byte.
+			ndef_raw_record raw  = entry_raw(ctx, &entry, x == 0);
+			size_t          size = ndef_raw_record_size(&raw);
+			if (entry.enc_offset != len || len + size > ctx->base_len) {
+				add_range(diffs, &diffs_len, len, size, page_size, page_offset);
+			} else if (entry.detail.flag_begin != begin || entry.detail.flag_end != end) {
+				add_range(diffs, &diffs_len, len, 1, page_size, page_offset);
+			}
+			
+			entry.detail.abs_index  = i;
+			entry.detail.flag_begin = begin;
+			entry.detail.flag_end   = end;
+			entry.enc_offset        = len;
+			plan[n++] = entry;
+			len += size;
+		}
+	}
+	
+	// Clip the ranges to the new message.
+	while (diffs_len && diffs[diffs_len - 1].offset >= len) diffs_len --;
+	if (diffs_len && diffs[diffs_len - 1].offset + diffs[diffs_len - 1].len > len) {
+		diffs[diffs_len - 1].len = len - diffs[diffs_len - 1].offset;
+	}
+	
+	// Encode the planned raw records.
+	uint8_t *data = len ? ndef_malloc(len, NDEF_ALLOC_OUTPUT) : NULL;
+	if (len && !data) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", len);
+		ctx_free(ctx, plan, NDEF_ALLOC_ARRAY);
+		ndef_free(diffs, NDEF_ALLOC_OUTPUT);
+		return fail(ctx, NDEF_ERR_NO_MEM, 0);
+	}
+	NDEF_PHASE_BEGIN(NDEF_PHASE_ENCODE);
+	ndef_ostream out = ndef_ostream_init_fixed(data, len);
+	for (size_t i = 0; i < count; i++) {
+		bool first = !i || plan[i - 1].detail.abs_index != plan[i].detail.abs_index;
+		ndef_raw_record raw = entry_raw(ctx, plan + i, first);
+		ndef_raw_record_encode(&out, &raw);
+	}
+	NDEF_PHASE_END(NDEF_PHASE_ENCODE);
+	
+	// The new encoding is the baseline from now on.
+	if (ctx->enc) ctx_free(ctx, ctx->enc, NDEF_ALLOC_ARRAY);
+	ctx->enc      = plan;
+	ctx->enc_cap  = count;
+	ctx->enc_len  = count;
+	ctx->base_len = len;
+	for (size_t i = 0, x = 0; i < ctx->abs_records_len; i++) {
+		size_t chunks = 0;
+		while (x + chunks < count && plan[x + chunks].detail.abs_index == i) chunks ++;
+		ctx->abs_records[i].raw_index = x;
+		ctx->abs_records[i].raw_len   = chunks;
+		x += chunks;
+	}
+	
+	*out_data   = data;
+	*out_len    = len;
+	*ranges     = diffs;
+	*ranges_len = diffs_len;
+	return true;
+}
+
+// Whether record `index` was inserted or replaced since the last decode or `ndef_encode_diff`.
+bool ndef_record_is_dirty(ndef_ctx ctx, size_t index) {
+	MAGIC_CHECK(false)
+	if (index >= ctx->abs_records_len) return false;
+	const ndef_record *abs = ctx->abs_records + index;
+	return !abs->raw_len || ctx->enc[abs->raw_index].enc_offset == NO_OFFSET;
+}
 
 // Get the number of raw NDEF records.
 size_t ndef_raw_records_len(ndef_ctx ctx) {
-	MAGIC_CHECK
-	return ctx->raw_records_len;
+	MAGIC_CHECK(0)
+	return ctx->enc_len;
 }
 
 // Get a pointer to the raw NDEF records.
+// They are reconstructed from the abstract records and remain valid until the context is next modified.
 const ndef_raw_record *ndef_raw_records(ndef_ctx ctx) {
-	return ctx->raw_records;
+	MAGIC_CHECK(NULL)
+	
+	// Make room for the reconstructed records.
+	if (ctx->enc_len > ctx->raw_cache_cap) {
+		void *mem = ctx_realloc(ctx, ctx->raw_cache, sizeof(ndef_raw_record) * ctx->enc_len, NDEF_ALLOC_ARRAY);
+		if (!mem) {
+			NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", sizeof(ndef_raw_record) * ctx->enc_len);
+			fail(ctx, NDEF_ERR_NO_MEM, 0);
+			return NULL;
+		}
+		ctx->raw_cache     = mem;
+		ctx->raw_cache_cap = ctx->enc_len;
+	}
+	
+	for (size_t i = 0; i < ctx->enc_len; i++) {
+		ctx->raw_cache[i] = entry_raw(ctx, ctx->enc + i, i == ctx->abs_records[ctx->enc[i].detail.abs_index].raw_index);
+	}
+	
+	return ctx->raw_cache;
 }
 
-// Delete all raw records but keep abstract ones.
+// Delete all raw records but keep abstract ones and the allocated memory.
 void ndef_raw_clear(ndef_ctx ctx) {
-	MAGIC_CHECK
+	MAGIC_CHECK()
 	
-	// Clear raw records.
-	if (ctx->raw_records) free(ctx->raw_records);
-	ctx->raw_records_cap = 0;
-	ctx->raw_records_len = 0;
+	// Clear raw records, keeping the arrays for reuse.
+	ctx->enc_len  = 0;
+	ctx->base_len = 0;
 	
 	// Remove pointers from abstract records.
 	for (size_t i = 0; i < ctx->abs_records_len; i++) {
@@ -661,24 +1569,56 @@ void ndef_raw_clear(ndef_ctx ctx) {
 
 // Get the number of abstract NDEF records.
 size_t ndef_records_len(ndef_ctx ctx) {
-	MAGIC_CHECK
+	MAGIC_CHECK(0)
 	return ctx->abs_records_len;
 }
 
 // Get a pointer to the abstract NDEF records.
 const ndef_record *ndef_records(ndef_ctx ctx) {
-	MAGIC_CHECK
+	MAGIC_CHECK(NULL)
 	return ctx->abs_records;
 }
 
+// Delete all records but keep the allocated memory for reuse.
+void ndef_reset(ndef_ctx ctx) {
+	MAGIC_CHECK()
+	
+	// Free the data owned by the records.
+	for (size_t i = 0; i < ctx->abs_records_len; i++) {
+		ndef_record_destroy(ctx->abs_records[i]);
+	}
+	
+	// Let go of shared data.
+	pool_release(ctx->pool);
+	ctx->pool = NULL;
+	
+	ctx->enc_len         = 0;
+	ctx->abs_records_len = 0;
+	ctx->arena_len       = 0;
+	ctx->base_len        = 0;
+	ctx->generation      ++;
+	ctx->error           = NDEF_OK;
+	ctx->error_offset    = 0;
+}
+
 // Delete all records.
 void ndef_clear(ndef_ctx ctx) {
-	if (ctx->raw_records) free(ctx->raw_records);
-	if (ctx->abs_records) free(ctx->abs_records);
-	ctx->raw_records_cap = 0;
-	ctx->raw_records_len = 0;
+	MAGIC_CHECK()
+	ndef_reset(ctx);
+	if (ctx->fixed) return;
+	
+	if (ctx->enc)         ctx_free(ctx, ctx->enc,         NDEF_ALLOC_ARRAY);
+	if (ctx->raw_cache)   ctx_free(ctx, ctx->raw_cache,   NDEF_ALLOC_ARRAY);
+	if (ctx->abs_records) ctx_free(ctx, ctx->abs_records, NDEF_ALLOC_ARRAY);
+	if (ctx->arena)       ctx_free(ctx, ctx->arena,       NDEF_ALLOC_ARENA);
+	ctx->enc             = NULL;
+	ctx->enc_cap         = 0;
+	ctx->raw_cache       = NULL;
+	ctx->raw_cache_cap   = 0;
+	ctx->abs_records     = NULL;
 	ctx->abs_records_cap = 0;
-	ctx->abs_records_len = 0;
+	ctx->arena           = NULL;
+	ctx->arena_cap       = 0;
 }
 
 
@@ -687,68 +1627,162 @@ void ndef_splice(ndef_ctx ctx, size_t index) {
 	ndef_splice_n(ctx, index, 1);
 }
 
+// Remove the raw records of abstract records `index` up to `index + len`.
+// The remaining raw records are renumbered, and their abstract indices past the range reduced by `shift`.
+static void drop_raw(ndef_ctx ctx, size_t index, size_t len, size_t shift) {
+	size_t kept = 0;
+	for (size_t i = 0; i < ctx->enc_len; i++) {
+		ndef_enc_entry entry = ctx->enc[i];
+		size_t         abs   = entry.detail.abs_index;
+		if (abs >= index && abs < index + len) continue;
+		
+		// Keep the abstract record pointing at its first raw record.
+		if (ctx->abs_records[abs].raw_index == i) ctx->abs_records[abs].raw_index = kept;
+		if (abs >= index + len) entry.detail.abs_index -= shift;
+		ctx->enc[kept++] = entry;
+	}
+	ctx->enc_len = kept;
+}
+
 // Delete one or more NDEF records in the message.
 void ndef_splice_n(ndef_ctx ctx, size_t index, size_t len) {
-	MAGIC_CHECK
+	MAGIC_CHECK()
+	
+	// Bounds check.
+	if (index >= ctx->abs_records_len) return;
+	if (len > ctx->abs_records_len - index) len = ctx->abs_records_len - index;
+	if (!len) return;
+	
+	// Free the removed records and their raw records.
+	drop_raw(ctx, index, len, len);
+	for (size_t i = 0; i < len; i++) {
+		ndef_record_destroy(ctx->abs_records[index + i]);
+	}
+	
+	// Shift the tail down.
+	memmove(
+		ctx->abs_records + index,
+		ctx->abs_records + index + len,
+		sizeof(ndef_record) * (ctx->abs_records_len - index - len)
+	);
+	ctx->abs_records_len -= len;
+	ctx->generation      ++;
+}
+
+// Replace an NDEF record in the message, keeping all others in place.
+// Does not create a corresponding raw record.
+bool ndef_replace(ndef_ctx ctx, size_t index, ndef_record record) {
+	MAGIC_CHECK(false)
+	
+	ndef_record copy;
+	if (!ndef_record_clone(record, &copy)) return fail(ctx, NDEF_ERR_NO_MEM, 0);
+	if (!ndef_replace_mv(ctx, index, copy)) {
+		ndef_record_destroy(copy);
+		return false;
+	}
+	return true;
+}
+
+// Replace an NDEF record in the message, keeping all others in place.
+// Does not create a corresponding raw record.
+// Moves the input data; `ctx` shall take ownership of contained resources if and only if the operation is successful.
+bool ndef_replace_mv(ndef_ctx ctx, size_t index, ndef_record record) {
+	MAGIC_CHECK(false)
+	
+	// Bounds check.
+	if (index >= ctx->abs_records_len) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Record %zu does not exist", index);
+		return fail(ctx, NDEF_ERR_INVALID, 0);
+	}
+	
+	// The old encoding details no longer apply.
+	drop_raw(ctx, index, 1, 0);
+	ndef_record_destroy(ctx->abs_records[index]);
+	
+	record.raw_index = 0;
+	record.raw_len   = 0;
+	if (!record.kind) record.kind = ndef_classify(record);
+	ctx->abs_records[index] = record;
+	ctx->generation ++;
+	return true;
 }
 
 
 // Insert one or more NDEF records in an arbitrary index in the message.
 // Does not create a corresponding raw record.
 bool insert_n(ndef_ctx ctx, size_t index, const ndef_record *records, size_t len, bool is_move) {
-	MAGIC_CHECK
+	MAGIC_CHECK(false)
+	NDEF_PHASE_BEGIN(NDEF_PHASE_APPEND);
 	
 	// Bounds check.
 	if (index > ctx->abs_records_len) index = ctx->abs_records_len;
 	
+	// Limit check.
+	if (len > NDEF_MAX_RECORDS - ctx->abs_records_len) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Too many records (maximum is %zu)", (size_t) NDEF_MAX_RECORDS);
+		NDEF_PHASE_END(NDEF_PHASE_APPEND);
+		return fail(ctx, NDEF_ERR_TOO_LONG, 0);
+	}
+	
 	// Allocate memories.
 	size_t old_len = ctx->abs_records_len;
 	size_t new_len = ctx->abs_records_len + len;
-	if (new_len > ctx->abs_records_cap) {
+	if (new_len > ctx->abs_records_cap && ctx->fixed) {
+		NDEF_PHASE_END(NDEF_PHASE_APPEND);
+		return fixed_full(ctx, new_len, ctx->abs_records_cap);
+	} else if (new_len > ctx->abs_records_cap) {
 		// Determine new capacity.
 		size_t cap = ctx->abs_records_cap;
 		if (!cap) cap = 1;
 		while (new_len > cap) cap *= 2;
+		if (cap > NDEF_MAX_RECORDS) cap = NDEF_MAX_RECORDS;
 		
 		// Allocate new memory.
-		void *mem = realloc(ctx->abs_records, cap * sizeof(ndef_record));
+		void *mem = ctx_realloc(ctx, ctx->abs_records, cap * sizeof(ndef_record), NDEF_ALLOC_ARRAY);
 		if (!mem) {
-			printf("NDEF: Error: Out of memory (allocating %zu bytes)\n", (size_t) cap);
-			return false;
+			NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", cap * sizeof(ndef_record));
+			NDEF_PHASE_END(NDEF_PHASE_APPEND);
+			return fail(ctx, NDEF_ERR_NO_MEM, 0);
 		}
 		ctx->abs_records     = mem;
 		ctx->abs_records_cap = cap;
 	}
 	
 	// Relocate objects.
-	for (ssize_t i = old_len - index - 1; i >= 0; i--) {
-		ctx->abs_records[old_len + i] = ctx->abs_records[index + i];
-	}
+	memmove(ctx->abs_records + index + len, ctx->abs_records + index, sizeof(ndef_record) * (old_len - index));
 	
 	// Fill in new objects.
 	size_t i;
 	for (i = 0; i < len; i ++) {
 		ndef_record *ptr = ctx->abs_records + index + i;
 		*ptr = records[i];
+		if (!ptr->kind) ptr->kind = ndef_classify(*ptr);
+		// New records have no raw records yet.
+		ptr->raw_index = 0;
+		ptr->raw_len   = 0;
 		if (!is_move) {
+			ptr->borrowed = 0;
+			ptr->type     = NULL;
+			ptr->payload  = NULL;
+			ptr->id       = NULL;
 			if (ptr->type_len) {
-				ptr->type    = malloc(ptr->type_len);
+				ptr->type    = ndef_malloc(ptr->type_len, NDEF_ALLOC_FIELD);
 				if (!ptr->type) break;
 				memcpy(ptr->type, records[i].type, ptr->type_len);
 			}
 			if (ptr->payload_len) {
-				ptr->payload = malloc(ptr->payload_len);
+				ptr->payload = ndef_malloc(ptr->payload_len, NDEF_ALLOC_PAYLOAD);
 				if (!ptr->payload) {
-					if (ptr->type) free(ptr->type);
+					if (ptr->type) ndef_free(ptr->type, NDEF_ALLOC_FIELD);
 					break;
 				}
 				memcpy(ptr->payload, records[i].payload, ptr->payload_len);
 			}
 			if (ptr->id_len) {
-				ptr->id      = malloc(ptr->id_len);
+				ptr->id      = ndef_malloc(ptr->id_len, NDEF_ALLOC_FIELD);
 				if (!ptr->id) {
-					if (ptr->type) free(ptr->type);
-					if (ptr->payload) free(ptr->payload);
+					if (ptr->type) ndef_free(ptr->type, NDEF_ALLOC_FIELD);
+					if (ptr->payload) ndef_free(ptr->payload, NDEF_ALLOC_PAYLOAD);
 					break;
 				}
 				memcpy(ptr->id, records[i].id, ptr->id_len);
@@ -760,18 +1794,27 @@ bool insert_n(ndef_ctx ctx, size_t index, const ndef_record *records, size_t len
 	if (!is_move && i < len) {
 		// Free memory after unsuccessful allocation.
 		for (size_t x = 0; x < i; x++) {
-			ndef_record_destroy(ctx->abs_records[index + i]);
+			ndef_record_destroy(ctx->abs_records[index + x]);
 		}
 		
 		// Undo the shifting operation too.
-		for (size_t i = 0; i < old_len - index; i++) {
-			ctx->abs_records[index + i] = ctx->abs_records[old_len + i];
-		}
+		memmove(ctx->abs_records + index, ctx->abs_records + index + len, sizeof(ndef_record) * (old_len - index));
 		
-		return false;
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (copying record %zu)", i);
+		NDEF_PHASE_END(NDEF_PHASE_APPEND);
+		return fail(ctx, NDEF_ERR_NO_MEM, 0);
+	}
+	
+	// Keep the raw records pointing at the same abstract records; appending never moves any.
+	if (index < old_len) {
+		for (size_t i = 0; i < ctx->enc_len; i++) {
+			if (ctx->enc[i].detail.abs_index >= index) ctx->enc[i].detail.abs_index += len;
+		}
 	}
 	
 	ctx->abs_records_len = new_len;
+	ctx->generation      ++;
+	NDEF_PHASE_END(NDEF_PHASE_APPEND);
 	return true;
 }
 
@@ -0,0 +1,125 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "ndef_alloc.h"
+#include "ndef_stats.h"
+
+#include <stdlib.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif
+
+
+
+static void *default_alloc(void *cookie, size_t size, ndef_alloc_kind kind) {
+	(void) cookie;
+	(void) kind;
+	return malloc(size);
+}
+
+static void *default_realloc(void *cookie, void *ptr, size_t size, ndef_alloc_kind kind) {
+	(void) cookie;
+	(void) kind;
+	return realloc(ptr, size);
+}
+
+static void default_free(void *cookie, void *ptr, ndef_alloc_kind kind) {
+	(void) cookie;
+	(void) kind;
+	free(ptr);
+}
+
+// Allocator that uses `malloc`, `realloc` and `free`.
+const ndef_allocator ndef_default_allocator = {
+	default_alloc, default_realloc, default_free, NULL,
+};
+
+// Allocator used for records and for memory handed to the caller.
+static const ndef_allocator *global_alloc = &ndef_default_allocator;
+
+// Set the allocator used for records and for memory handed to the caller, or NULL for the default.
+// It must outlive everything allocated with it. Not thread-safe; set it before using the library.
+void ndef_set_allocator(const ndef_allocator *alloc) {
+	global_alloc = alloc ? alloc : &ndef_default_allocator;
+}
+
+// Get the allocator used for records and for memory handed to the caller.
+const ndef_allocator *ndef_get_allocator() {
+	return global_alloc;
+}
+
+// Allocate memory with the global allocator.
+void *ndef_malloc(size_t size, ndef_alloc_kind kind) {
+	NDEF_STATS_ALLOC(size);
+	return global_alloc->alloc(global_alloc->cookie, size, kind);
+}
+
+// Resize memory allocated with `ndef_malloc`.
+void *ndef_realloc(void *ptr, size_t size, ndef_alloc_kind kind) {
+	NDEF_STATS_ALLOC(size);
+	return global_alloc->realloc(global_alloc->cookie, ptr, size, kind);
+}
+
+// Free memory allocated by the library, such as encoded messages and extracted strings.
+// Equivalent to `free` unless a different allocator was set.
+void ndef_free(void *ptr, ndef_alloc_kind kind) {
+	if (ptr) global_alloc->free(global_alloc->cookie, ptr, kind);
+}
+
+
+
+#ifdef ESP_PLATFORM
+// Determine the capabilities to use for an allocation.
+static uint32_t heap_caps_for(const ndef_heap_caps_config *config, size_t size, ndef_alloc_kind kind) {
+	if (kind == NDEF_ALLOC_ARRAY || kind == NDEF_ALLOC_FIELD || size < config->large_threshold) {
+		return config->small_caps;
+	}
+	return config->large_caps;
+}
+
+static void *heap_caps_alloc_cb(void *cookie, size_t size, ndef_alloc_kind kind) {
+	const ndef_heap_caps_config *config = cookie;
+	return heap_caps_malloc_prefer(size, 2, heap_caps_for(config, size, kind), MALLOC_CAP_8BIT);
+}
+
+static void *heap_caps_realloc_cb(void *cookie, void *ptr, size_t size, ndef_alloc_kind kind) {
+	const ndef_heap_caps_config *config = cookie;
+	return heap_caps_realloc_prefer(ptr, size, 2, heap_caps_for(config, size, kind), MALLOC_CAP_8BIT);
+}
+
+static void heap_caps_free_cb(void *cookie, void *ptr, ndef_alloc_kind kind) {
+	(void) cookie;
+	(void) kind;
+	heap_caps_free(ptr);
+}
+
+// Make an allocator that places memory with `heap_caps_malloc`, falling back to any 8-bit capable memory.
+// `config` must outlive the allocator.
+ndef_allocator ndef_heap_caps_allocator(const ndef_heap_caps_config *config) {
+	return (ndef_allocator) {
+		heap_caps_alloc_cb, heap_caps_realloc_cb, heap_caps_free_cb, (void *) config,
+	};
+}
+#endif
@@ -0,0 +1,241 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "ndef_batch.h"
+#include "ndef_log.h"
+
+#include <stdatomic.h>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+
+
+// Shared state of a batch operation.
+typedef struct batch_s batch_t;
+struct batch_s {
+	// Index of the next item to claim.
+	atomic_size_t        next;
+	// Number of items processed.
+	atomic_size_t        done;
+	// Set when any item failed.
+	atomic_bool          failed;
+	// Number of items.
+	size_t               count;
+	// Whether workers need a context of their own.
+	bool                 needs_ctx;
+	// Process item `index`, using the worker's context if it has one.
+	bool               (*work)(batch_t *batch, ndef_ctx ctx, size_t index);
+	
+	// Data to decode.
+	uint8_t *const      *data;
+	// Length of data to decode.
+	const size_t        *len;
+	// How to decode the data.
+	ndef_decode_mode     mode;
+	// Callback for decoded messages.
+	ndef_batch_cb        cb;
+	// Cookie passed to `cb`.
+	void                *cookie;
+	
+	// Contexts to encode.
+	const ndef_ctx      *ctx;
+	// Encoded data.
+	uint8_t            **out_data;
+	// Length of encoded data.
+	size_t              *out_len;
+	
+#ifdef ESP_PLATFORM
+	// Given by every worker task when it finishes.
+	SemaphoreHandle_t    finished;
+#endif
+};
+
+// Claim and process items until there are none left.
+static void run_worker(batch_t *batch) {
+	ndef_ctx ctx = NULL;
+	if (batch->needs_ctx) {
+		ctx = ndef_init();
+		// Leave the work to the other workers.
+		if (!ctx) return;
+	}
+	
+	while (1) {
+		size_t index = atomic_fetch_add(&batch->next, 1);
+		if (index >= batch->count) break;
+		if (!batch->work(batch, ctx, index)) atomic_store(&batch->failed, true);
+		atomic_fetch_add(&batch->done, 1);
+	}
+	
+	if (ctx) ndef_destroy(ctx);
+}
+
+#ifdef ESP_PLATFORM
+// FreeRTOS task entrypoint for workers.
+static void worker_task(void *arg) {
+	batch_t *batch = arg;
+	run_worker(batch);
+	xSemaphoreGive(batch->finished);
+	vTaskDelete(NULL);
+}
+
+// Determine the default number of workers.
+static size_t default_workers() {
+	return portNUM_PROCESSORS;
+}
+#else
+// POSIX thread entrypoint for workers.
+static void *worker_thread(void *arg) {
+	run_worker(arg);
+	return NULL;
+}
+
+// Determine the default number of workers.
+static size_t default_workers() {
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	return cores > 0 ? cores : 1;
+}
+#endif
+
+// Run a batch operation on the calling thread and up to `workers - 1` additional ones.
+// Returns false if any item failed or could not be processed.
+static bool run_batch(batch_t *batch, size_t workers) {
+	atomic_init(&batch->next,   0);
+	atomic_init(&batch->done,   0);
+	atomic_init(&batch->failed, false);
+	
+	if (!workers) workers = default_workers();
+	if (workers > batch->count) workers = batch->count;
+	size_t spawned = 0;
+	
+#ifdef ESP_PLATFORM
+	// Start worker tasks; the batch runs with fewer of them if this fails.
+	batch->finished = workers > 1 ? xSemaphoreCreateCounting(workers - 1, 0) : NULL;
+	if (batch->finished) {
+		UBaseType_t prio = uxTaskPriorityGet(NULL);
+		for (; spawned < workers - 1; spawned++) {
+			if (xTaskCreate(worker_task, "ndef_batch", NDEF_BATCH_STACK_SIZE, batch, prio, NULL) != pdPASS) break;
+		}
+	}
+	
+	run_worker(batch);
+	
+	// Wait for the worker tasks.
+	for (size_t i = 0; i < spawned; i++) {
+		xSemaphoreTake(batch->finished, portMAX_DELAY);
+	}
+	if (batch->finished) vSemaphoreDelete(batch->finished);
+#else
+	// Start worker threads; the batch runs with fewer of them if this fails.
+	pthread_t *threads = workers > 1 ? ndef_malloc(sizeof(pthread_t) * (workers - 1), NDEF_ALLOC_ARRAY) : NULL;
+	if (threads) {
+		for (; spawned < workers - 1; spawned++) {
+			if (pthread_create(&threads[spawned], NULL, worker_thread, batch)) break;
+		}
+	}
+	
+	run_worker(batch);
+	
+	// Wait for the worker threads.
+	for (size_t i = 0; i < spawned; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	if (threads) ndef_free(threads, NDEF_ALLOC_ARRAY);
+#endif
+	
+	if (atomic_load(&batch->done) < batch->count) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (batch of %zu items incomplete)", batch->count);
+		return false;
+	}
+	return !atomic_load(&batch->failed);
+}
+
+
+
+// Decode a single item of a batch.
+static bool decode_item(batch_t *batch, ndef_ctx ctx, size_t index) {
+	size_t len = batch->len[index];
+	bool   ok;
+	switch (batch->mode) {
+		default:
+		case NDEF_DECODE_COPY:  ok = ndef_decode_into      (ctx, batch->data[index], &len); break;
+		case NDEF_DECODE_VIEW:  ok = ndef_decode_view_into (ctx, batch->data[index], &len); break;
+		case NDEF_DECODE_ARENA: ok = ndef_decode_arena_into(ctx, batch->data[index], &len); break;
+	}
+	if (batch->cb) batch->cb(batch->cookie, index, ctx, ok);
+	return ok;
+}
+
+// Decode `count` blobs of NDEF data, spread over up to `workers` threads (0 for one per core).
+// Every worker decodes into a single reused context, which is passed to `cb` for each message.
+// Record types must be registered before starting a batch.
+// Returns false if any of the messages could not be decoded completely.
+bool ndef_decode_batch(uint8_t *const *data, const size_t *len, size_t count, ndef_decode_mode mode, ndef_batch_cb cb, void *cookie, size_t workers) {
+	if (!count) return true;
+	if (!data || !len) return false;
+	
+	batch_t batch = {
+		.count     = count,
+		.needs_ctx = true,
+		.work      = decode_item,
+		.data      = data,
+		.len       = len,
+		.mode      = mode,
+		.cb        = cb,
+		.cookie    = cookie,
+	};
+	return run_batch(&batch, workers);
+}
+
+// Encode a single item of a batch.
+static bool encode_item(batch_t *batch, ndef_ctx ctx, size_t index) {
+	(void) ctx;
+	batch->out_data[index] = NULL;
+	batch->out_len[index]  = 0;
+	return ndef_encode(batch->ctx[index], &batch->out_data[index], &batch->out_len[index]);
+}
+
+// Encode `count` contexts, spread over up to `workers` threads (0 for one per core).
+// Every context may only appear once; the results are stored in `out_data` and `out_len` like `ndef_encode`.
+// Returns false if any of the messages could not be encoded, in which case its `out_data` is NULL.
+bool ndef_encode_batch(const ndef_ctx *ctx, size_t count, uint8_t **out_data, size_t *out_len, size_t workers) {
+	if (!count) return true;
+	if (!ctx || !out_data || !out_len) return false;
+	
+	batch_t batch = {
+		.count     = count,
+		.needs_ctx = false,
+		.work      = encode_item,
+		.ctx       = ctx,
+		.out_data  = out_data,
+		.out_len   = out_len,
+	};
+	return run_batch(&batch, workers);
+}
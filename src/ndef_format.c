@@ -0,0 +1,439 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+#include "ndef_format.h"
+#include "ndef_record_types.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+
+
+// Maximum nesting depth of messages and records that is rendered.
+#define RECURSION_LIMIT 8
+
+// Output being rendered, either into a caller buffer or flushed to a file in chunks.
+typedef struct {
+	// Buffer to render into.
+	char       *buf;
+	// Number of bytes that may be rendered into the buffer, excluding any NUL terminator.
+	size_t      cap;
+	// Number of bytes in the buffer.
+	size_t      len;
+	// Length of the full output so far.
+	size_t      total;
+	// File to write the buffer to when it is full, or NULL to truncate instead.
+	FILE       *flush;
+	// Output format.
+	ndef_format format;
+} fmt_out;
+
+static const char hex_chars[] = "0123456789abcdef";
+
+// Render a message.
+static void format_message(fmt_out *out, ndef_ctx ctx, size_t recursion_limit, size_t indent);
+
+
+
+// Add `len` bytes to the output.
+static void put(fmt_out *out, const char *data, size_t len) {
+	out->total += len;
+	while (len) {
+		size_t n = out->cap - out->len;
+		if (n > len) n = len;
+		if (n) memcpy(out->buf + out->len, data, n);
+		out->len += n;
+		data     += n;
+		len      -= n;
+		
+		// Without a file to flush to, the rest is only counted.
+		if (!len || !out->flush) break;
+		fwrite(out->buf, 1, out->len, out->flush);
+		out->len = 0;
+	}
+}
+
+// Add a NUL-terminated string to the output.
+static void put_str(fmt_out *out, const char *str) {
+	put(out, str, strlen(str));
+}
+
+// Add formatted text of at most 63 characters to the output.
+static void put_fmt(fmt_out *out, const char *fmt, ...) {
+	char    tmp[64];
+	va_list va;
+	va_start(va, fmt);
+	int len = vsnprintf(tmp, sizeof(tmp), fmt, va);
+	va_end(va);
+	if (len > 0) put(out, tmp, (size_t) len < sizeof(tmp) ? (size_t) len : sizeof(tmp) - 1);
+}
+
+// Add `indent` spaces to the output.
+static void put_indent(fmt_out *out, size_t indent) {
+	static const char spaces[] = "                ";
+	while (indent) {
+		size_t n = indent < sizeof(spaces) - 1 ? indent : sizeof(spaces) - 1;
+		put(out, spaces, n);
+		indent -= n;
+	}
+}
+
+// Add bytes as JSON string contents, escaping as needed.
+// With `binary` set, bytes past ASCII are escaped too, since they need not be UTF-8.
+static void put_json_str(fmt_out *out, const uint8_t *data, size_t len, bool binary) {
+	size_t start = 0;
+	for (size_t i = 0; i < len; i++) {
+		uint8_t c = data[i];
+		if (c >= 0x20 && c != '"' && c != '\\' && (c < 0x7f || !binary)) continue;
+		
+		// Add the run of plain characters, then the escape.
+		put(out, (const char *) data + start, i - start);
+		start = i + 1;
+		char esc[6] = { '\\', 'u', '0', '0', hex_chars[c >> 4], hex_chars[c & 15] };
+		switch (c) {
+			case '"':  put(out, "\\\"", 2); break;
+			case '\\': put(out, "\\\\", 2); break;
+			case '\n': put(out, "\\n",  2); break;
+			case '\r': put(out, "\\r",  2); break;
+			case '\t': put(out, "\\t",  2); break;
+			default:   put(out, esc,    6); break;
+		}
+	}
+	put(out, (const char *) data + start, len - start);
+}
+
+// Add `len` bytes of text, escaping it for JSON output.
+static void put_text_n(fmt_out *out, const uint8_t *data, size_t len) {
+	if (out->format == NDEF_FORMAT_JSON) {
+		put_json_str(out, data, len, false);
+	} else {
+		put(out, (const char *) data, len);
+	}
+}
+
+// Add text, which is NUL-terminated or `len` bytes long, escaping it for JSON output.
+static void put_text(fmt_out *out, const uint8_t *data, size_t len) {
+	put_text_n(out, data, strnlen((const char *) data, len));
+}
+
+// Add UTF-16 text as UTF-8, converted by `ndef_utf16_to_utf8`.
+// Short text is converted on the stack; longer text needs a temporary allocation and is truncated without it.
+static void put_utf16(fmt_out *out, const uint8_t *in, size_t len) {
+	char   tmp[128];
+	char  *utf8     = tmp;
+	size_t utf8_len = ndef_utf16_to_utf8(in, len, tmp, sizeof(tmp));
+	if (utf8_len >= sizeof(tmp)) {
+		char *mem = ndef_malloc(utf8_len + 1, NDEF_ALLOC_OUTPUT);
+		if (mem) {
+			ndef_utf16_to_utf8(in, len, mem, utf8_len + 1);
+			utf8 = mem;
+		} else {
+			utf8_len = strlen(tmp);
+		}
+	}
+	put_text_n(out, (const uint8_t *) utf8, utf8_len);
+	if (utf8 != tmp) ndef_free(utf8, NDEF_ALLOC_OUTPUT);
+}
+
+// Add a simple hexdump, one line of 16 bytes at a time.
+static void put_hexdump(fmt_out *out, const uint8_t *data, size_t size, size_t indent) {
+	const size_t cols = 16;
+	for (size_t y = 0; y * cols < size; y++) {
+		const uint8_t *row   = data + y * cols;
+		size_t         count = size - y * cols < cols ? size - y * cols : cols;
+		char           line[16 * 3 + 2 + 16 + 1];
+		size_t         len = 0;
+		
+		// Hex chars, padded to full width if there is more than one line.
+		for (size_t x = 0; x < count; x++) {
+			if (x) line[len++] = ' ';
+			line[len++] = hex_chars[row[x] >> 4];
+			line[len++] = hex_chars[row[x] & 15];
+		}
+		if (size > cols) {
+			for (size_t x = count; x < cols; x++) {
+				line[len++] = ' '; line[len++] = ' '; line[len++] = ' ';
+			}
+		}
+		
+		// ASCII chars.
+		line[len++] = ' ';
+		line[len++] = ' ';
+		for (size_t x = 0; x < count; x++) {
+			line[len++] = row[x] >= 0x20 && row[x] <= 0x7e ? row[x] : '.';
+		}
+		line[len++] = '\n';
+		
+		put_indent(out, indent);
+		put(out, line, len);
+	}
+}
+
+// Add a labelled field as text: short ones on the same line, long ones below it.
+static void put_field(fmt_out *out, const char *label, const uint8_t *data, size_t len, size_t indent) {
+	put_indent(out, indent);
+	put_str(out, label);
+	put_fmt(out, "%zu byte", len);
+	if (len <= 16) {
+		if (len != 1) put(out, "s", 1);
+		put_hexdump(out, data, len, 2);
+	} else {
+		put(out, "s:\n", 3);
+		put_hexdump(out, data, len, indent + 2);
+	}
+}
+
+// Add a labelled field as a JSON string.
+static void put_json_field(fmt_out *out, const char *key, const uint8_t *data, size_t len) {
+	put_str(out, key);
+	put(out, "\"", 1);
+	put_json_str(out, data, len, true);
+	put(out, "\"", 1);
+}
+
+
+
+// Render a record as text.
+static void format_record_text(fmt_out *out, ndef_record rec, size_t recursion_limit, size_t indent) {
+	// Check recursion limit.
+	if (!recursion_limit) {
+		put_indent(out, indent);
+		put_str(out, "(recursion limited)\n");
+		return;
+	}
+	
+	// Check empty record; any fields it does have are still shown.
+	bool no_fields = !rec.id_len && !rec.payload_len && !rec.type_len;
+	put_indent(out, indent);
+	if (no_fields || rec.tnf == NDEF_TNF_EMPTY) {
+		put_str(out, "(empty record)\n");
+		if (no_fields) return;
+	} else {
+		put_str(out, "NDEF record:\n");
+		indent += 2;
+	}
+	
+	if (rec.id_len)   put_field(out, "ID:    ", rec.id,   rec.id_len,   indent);
+	if (rec.type_len) put_field(out, "Type:  ", rec.type, rec.type_len, indent);
+	
+	// Known kinds are shown decoded.
+	uint8_t kind = ndef_record_kind(rec);
+	if (kind == NDEF_KIND_SMARTPOSTER) {
+		put_indent(out, indent);
+		put_str(out, "Note:  Record is smart poster\n");
+		ndef_smartposter_view sp;
+		ndef_ctx inner = NULL;
+		if (ndef_record_get_smartposter_view(rec, &sp) && (sp.has_uri || sp.has_text)) {
+			inner = ndef_smartposter_view_decode(&sp);
+		}
+		if (inner) {
+			format_message(out, inner, recursion_limit - 1, indent);
+			ndef_destroy(inner);
+			return;
+		}
+		
+	} else if (kind == NDEF_KIND_URI) {
+		put_indent(out, indent);
+		put_str(out, "Note:  Record is URI\n");
+		ndef_uri_view uri;
+		if (ndef_record_get_uri_view(rec, &uri)) {
+			put_indent(out, indent);
+			put_str(out, "URI:   ");
+			put(out, uri.prefix, uri.prefix_len);
+			put_text(out, (const uint8_t *) uri.rest, uri.rest_len);
+			put(out, "\n", 1);
+			return;
+		}
+		
+	} else if (kind == NDEF_KIND_TEXT) {
+		put_indent(out, indent);
+		put_str(out, "Note:  Record is text\n");
+		ndef_text_view text;
+		if (ndef_record_get_text_view(rec, &text)) {
+			put_indent(out, indent);
+			put_str(out, "Lang:  ");
+			put_text(out, (const uint8_t *) text.lang, text.lang_len);
+			put(out, "\n", 1);
+			put_indent(out, indent);
+			put_str(out, "Text:  ");
+			if (text.is_utf16) put_utf16(out, text.text, text.text_len);
+			else put_text(out, text.text, text.text_len);
+			put(out, "\n", 1);
+			return;
+		}
+	}
+	
+	// Default: Simple info dump.
+	if (rec.payload_len) {
+		put_field(out, "Payload: ", rec.payload, rec.payload_len, indent);
+	} else {
+		put_indent(out, indent);
+		put_str(out, "Payload: empty\n");
+	}
+}
+
+// Render a record as JSON.
+static void format_record_json(fmt_out *out, ndef_record rec, size_t recursion_limit) {
+	if (!recursion_limit) {
+		put_str(out, "null");
+		return;
+	}
+	
+	put_fmt(out, "{\"tnf\":%u", (unsigned) rec.tnf);
+	if (rec.type_len) put_json_field(out, ",\"type\":", rec.type, rec.type_len);
+	if (rec.id_len)   put_json_field(out, ",\"id\":",   rec.id,   rec.id_len);
+	
+	// Known kinds are shown decoded.
+	uint8_t kind = ndef_record_kind(rec);
+	const ndef_type_handler *handler = ndef_kind_handler(kind);
+	if (handler && handler->name) {
+		put_str(out, ",\"kind\":\"");
+		put_text(out, (const uint8_t *) handler->name, strlen(handler->name));
+		put(out, "\"", 1);
+	}
+	bool decoded = false;
+	if (kind == NDEF_KIND_SMARTPOSTER) {
+		ndef_smartposter_view sp;
+		ndef_ctx inner = NULL;
+		if (ndef_record_get_smartposter_view(rec, &sp) && (sp.has_uri || sp.has_text)) {
+			inner = ndef_smartposter_view_decode(&sp);
+		}
+		if (inner) {
+			put_str(out, ",\"message\":");
+			format_message(out, inner, recursion_limit - 1, 0);
+			ndef_destroy(inner);
+			decoded = true;
+		}
+		
+	} else if (kind == NDEF_KIND_URI) {
+		ndef_uri_view uri;
+		if (ndef_record_get_uri_view(rec, &uri)) {
+			put_str(out, ",\"uri\":\"");
+			put_text(out, (const uint8_t *) uri.prefix, uri.prefix_len);
+			put_text(out, (const uint8_t *) uri.rest, uri.rest_len);
+			put(out, "\"", 1);
+			decoded = true;
+		}
+		
+	} else if (kind == NDEF_KIND_TEXT) {
+		ndef_text_view text;
+		if (ndef_record_get_text_view(rec, &text)) {
+			put_str(out, ",\"lang\":\"");
+			put_text(out, (const uint8_t *) text.lang, text.lang_len);
+			put_str(out, "\",\"text\":\"");
+			if (text.is_utf16) put_utf16(out, text.text, text.text_len);
+			else put_text(out, text.text, text.text_len);
+			put(out, "\"", 1);
+			decoded = true;
+		}
+	}
+	
+	// Default: Payload as hex.
+	if (!decoded && rec.payload_len) {
+		put_str(out, ",\"payload\":\"");
+		for (size_t i = 0; i < rec.payload_len; i++) {
+			char byte[2] = { hex_chars[rec.payload[i] >> 4], hex_chars[rec.payload[i] & 15] };
+			put(out, byte, 2);
+		}
+		put(out, "\"", 1);
+	}
+	put(out, "}", 1);
+}
+
+// Render a message.
+static void format_message(fmt_out *out, ndef_ctx ctx, size_t recursion_limit, size_t indent) {
+	size_t             len     = ndef_records_len(ctx);
+	const ndef_record *records = ndef_records(ctx);
+	
+	if (out->format == NDEF_FORMAT_JSON) {
+		if (!recursion_limit) {
+			put_str(out, "null");
+			return;
+		}
+		put_str(out, "{\"records\":[");
+		for (size_t i = 0; i < len; i++) {
+			if (i) put(out, ",", 1);
+			format_record_json(out, records[i], recursion_limit - 1);
+		}
+		put_str(out, "]}");
+		return;
+	}
+	
+	// Check recursion limit.
+	put_indent(out, indent);
+	if (!recursion_limit) {
+		put_str(out, "(recursion limited)\n");
+		return;
+	}
+	
+	// Print number of records, then each of them.
+	if (len) {
+		put_fmt(out, "NDEF message: %zu record%s", len, len == 1 ? "\n" : "s\n");
+	} else {
+		put_str(out, "NDEF message: empty\n");
+	}
+	for (size_t i = 0; i < len; i++) {
+		format_record_text(out, records[i], recursion_limit - 1, indent + 2);
+	}
+}
+
+// Make an output that renders into a caller buffer of `cap` bytes.
+static fmt_out buf_out(char *buf, size_t cap, ndef_format format) {
+	return (fmt_out) { buf, cap ? cap - 1 : 0, 0, 0, NULL, format };
+}
+
+// NUL-terminate the output and get the length of the full output.
+static size_t buf_finish(fmt_out *out, size_t cap) {
+	if (cap) out->buf[out->len] = 0;
+	return out->total;
+}
+
+
+
+// Render hierarchical info about an NDEF message into `buf`, which is NUL-terminated if `cap` is nonzero.
+// Returns the length of the full output even if it was truncated, like `snprintf`.
+size_t ndef_format_info(ndef_ctx ctx, char *buf, size_t cap, ndef_format format) {
+	fmt_out out = buf_out(buf, cap, format);
+	format_message(&out, ctx, RECURSION_LIMIT, 0);
+	return buf_finish(&out, cap);
+}
+
+// Render hierarchical info about an NDEF record into `buf`, which is NUL-terminated if `cap` is nonzero.
+// Returns the length of the full output even if it was truncated, like `snprintf`.
+size_t ndef_record_format_info(ndef_record record, char *buf, size_t cap, ndef_format format) {
+	fmt_out out = buf_out(buf, cap, format);
+	if (format == NDEF_FORMAT_JSON) {
+		format_record_json(&out, record, RECURSION_LIMIT);
+	} else {
+		format_record_text(&out, record, RECURSION_LIMIT, 0);
+	}
+	return buf_finish(&out, cap);
+}
+
+// Print a hierarchical info about this NDEF message.
+void ndef_print_info(ndef_ctx ctx) {
+	char    buf[NDEF_PRINT_BUF_SIZE];
+	fmt_out out = { buf, sizeof(buf), 0, 0, stdout, NDEF_FORMAT_TEXT };
+	format_message(&out, ctx, RECURSION_LIMIT, 0);
+	fwrite(buf, 1, out.len, stdout);
+}
@@ -0,0 +1,283 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+#define NDEF_REVEAL_PRIVATE
+#include "ndef_image.h"
+#include "ndef_log.h"
+
+#include <string.h>
+
+
+
+// Type 2 TLV: the NDEF message.
+#define TLV_NDEF       0x03
+// Type 2 TLV: end of the TLV area.
+#define TLV_TERMINATOR 0xFE
+
+// Image being laid out; with `dry` set, only the lengths are counted.
+typedef struct {
+	// Image to fill in.
+	ndef_image img;
+	// Whether to count lengths without writing anything.
+	bool       dry;
+	// Number of bytes laid out.
+	size_t     len;
+	// Number of segments laid out.
+	size_t     segs_len;
+	// Number of inline bytes laid out.
+	size_t     inline_len;
+	// Whether the last segment is inline data, which the next inline bytes can extend.
+	bool       last_inline;
+} layout;
+
+
+
+// Note down why an operation on `img` failed.
+// Always returns false.
+static bool fail(ndef_image img, ndef_err error) {
+	img->error = error;
+	return false;
+}
+
+// Add bytes that are copied into the image.
+static void put_inline(layout *lay, const uint8_t *data, size_t len) {
+	if (!len) return;
+	if (!lay->dry) {
+		ndef_image img = lay->img;
+		memcpy(img->inline_data + lay->inline_len, data, len);
+		if (lay->last_inline) {
+			img->segs[lay->segs_len - 1].len += len;
+		} else {
+			img->segs[lay->segs_len] = (ndef_image_seg) { lay->len, len, img->inline_data + lay->inline_len };
+		}
+	}
+	if (!lay->last_inline) lay->segs_len ++;
+	lay->inline_len  += len;
+	lay->len         += len;
+	lay->last_inline  = true;
+}
+
+// Add bytes that are served from where they are.
+static void put_ref(layout *lay, const uint8_t *data, size_t len) {
+	if (!len) return;
+	if (!lay->dry) {
+		lay->img->segs[lay->segs_len] = (ndef_image_seg) { lay->len, len, data };
+	}
+	lay->segs_len    ++;
+	lay->len         += len;
+	lay->last_inline  = false;
+}
+
+// Lay out the records from the same raw records `ndef_encode` encodes.
+static void layout_records(layout *lay, ndef_ctx ctx) {
+	for (size_t i = 0; i < ctx->abs_records_len; i++) {
+		size_t chunks = ndef_enc_chunk_count(ctx, i);
+		for (size_t x = 0; x < chunks; x++) {
+			ndef_raw_record raw = ndef_make_raw(ctx, i, x, chunks);
+			uint8_t header[NDEF_RAW_HEADER_MAX];
+			
+			// Short fields are copied, long payloads are not.
+			put_inline(lay, header, ndef_raw_record_encode_header(&raw, header));
+			put_inline(lay, raw.type, raw.type_len);
+			if (raw.payload_len <= NDEF_IMAGE_INLINE_MAX) {
+				put_inline(lay, raw.payload, raw.payload_len);
+			} else {
+				put_ref(lay, raw.payload, raw.payload_len);
+			}
+			if (raw.flag_include_id_len) put_inline(lay, raw.id, raw.id_len);
+		}
+	}
+}
+
+// Lay out the framing that goes before a message of `msg_len` bytes.
+static void layout_prefix(layout *lay, size_t msg_len) {
+	uint8_t prefix[4];
+	size_t  prefix_len = 0;
+	switch (lay->img->format) {
+		case NDEF_IMAGE_RAW:
+			break;
+		case NDEF_IMAGE_T2_TLV:
+			prefix[prefix_len++] = TLV_NDEF;
+			if (msg_len < 0xff) {
+				prefix[prefix_len++] = msg_len;
+			} else {
+				prefix[prefix_len++] = 0xff;
+				prefix[prefix_len++] = msg_len >> 8;
+				prefix[prefix_len++] = msg_len;
+			}
+			break;
+		case NDEF_IMAGE_T4_NLEN:
+			prefix[prefix_len++] = msg_len >> 8;
+			prefix[prefix_len++] = msg_len;
+			break;
+		case NDEF_IMAGE_T4_ENLEN:
+			prefix[prefix_len++] = msg_len >> 24;
+			prefix[prefix_len++] = msg_len >> 16;
+			prefix[prefix_len++] = msg_len >> 8;
+			prefix[prefix_len++] = msg_len;
+			break;
+	}
+	put_inline(lay, prefix, prefix_len);
+}
+
+// Lay out the segments of the image anew.
+static bool build(ndef_image img) {
+	ndef_ctx ctx = img->ctx;
+	img->valid = false;
+	img->error = NDEF_OK;
+	
+	// Measure the message first, since the framing depends on its length.
+	layout dry = { .img = img, .dry = true };
+	layout_records(&dry, ctx);
+	size_t max = img->format == NDEF_IMAGE_T2_TLV || img->format == NDEF_IMAGE_T4_NLEN ? 0xfffe : UINT32_MAX;
+	if (dry.len > max) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Message too long (%zu bytes; maximum is %zu)", dry.len, max);
+		return fail(img, NDEF_ERR_TOO_LONG);
+	}
+	
+	// Make room for the message plus at most one segment of framing on either side.
+	size_t segs_cap   = dry.segs_len + 2;
+	size_t inline_cap = dry.inline_len + 5;
+	if (segs_cap > img->segs_cap) {
+		void *mem = ndef_realloc(img->segs, sizeof(ndef_image_seg) * segs_cap, NDEF_ALLOC_ARRAY);
+		if (!mem) {
+			NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", sizeof(ndef_image_seg) * segs_cap);
+			return fail(img, NDEF_ERR_NO_MEM);
+		}
+		img->segs     = mem;
+		img->segs_cap = segs_cap;
+	}
+	if (inline_cap > img->inline_cap) {
+		void *mem = ndef_realloc(img->inline_data, inline_cap, NDEF_ALLOC_ARRAY);
+		if (!mem) {
+			NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", inline_cap);
+			return fail(img, NDEF_ERR_NO_MEM);
+		}
+		img->inline_data = mem;
+		img->inline_cap  = inline_cap;
+	}
+	
+	// Lay out the framing and the message for real.
+	layout lay = { .img = img };
+	layout_prefix(&lay, dry.len);
+	layout_records(&lay, ctx);
+	if (img->format == NDEF_IMAGE_T2_TLV) {
+		uint8_t terminator = TLV_TERMINATOR;
+		put_inline(&lay, &terminator, 1);
+	}
+	
+	img->len        = lay.len;
+	img->segs_len   = lay.segs_len;
+	img->inline_len = lay.inline_len;
+	img->cursor     = 0;
+	img->generation = ctx->generation;
+	img->valid      = true;
+	return true;
+}
+
+// Find the segment containing `offset`, starting from the cursor since reads tend to be sequential.
+static size_t find_seg(ndef_image img, size_t offset) {
+	size_t cur = img->cursor;
+	for (size_t i = cur; i < img->segs_len && i < cur + 2; i++) {
+		if (offset >= img->segs[i].offset && offset - img->segs[i].offset < img->segs[i].len) return i;
+	}
+	
+	// Binary search for the last segment starting at or before `offset`.
+	size_t lo = 0, hi = img->segs_len;
+	while (hi - lo > 1) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (img->segs[mid].offset <= offset) lo = mid;
+		else hi = mid;
+	}
+	return lo;
+}
+
+
+
+// Create an encoded image of the records in `ctx`, which must outlive it.
+// The image is rebuilt on the next read after the records change; payloads are not copied.
+ndef_image ndef_image_init(ndef_ctx ctx, ndef_image_format format) {
+	if (!ctx || format > NDEF_IMAGE_T4_ENLEN) return NULL;
+	
+	ndef_image out = ndef_malloc(sizeof(ndef_image_s), NDEF_ALLOC_ARRAY);
+	if (!out) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", sizeof(ndef_image_s));
+		return NULL;
+	}
+	*out = (ndef_image_s) {
+		.ctx        = ctx,
+		.format     = format,
+		.generation = 0,
+		.valid      = false,
+		.error      = NDEF_OK,
+	};
+	
+	return out;
+}
+
+// Destroy an encoded image.
+void ndef_image_destroy(ndef_image img) {
+	if (img->segs)        ndef_free(img->segs,        NDEF_ALLOC_ARRAY);
+	if (img->inline_data) ndef_free(img->inline_data, NDEF_ALLOC_ARRAY);
+	ndef_free(img, NDEF_ALLOC_ARRAY);
+}
+
+// Rebuild the image if the records changed since it was last built.
+bool ndef_image_update(ndef_image img) {
+	if (img->valid && img->generation == ndef_get_generation(img->ctx)) return true;
+	return build(img);
+}
+
+// Get the length of the image, including framing, or 0 if it cannot be built.
+size_t ndef_image_len(ndef_image img) {
+	return ndef_image_update(img) ? img->len : 0;
+}
+
+// Copy up to `len` bytes of the image at `offset` into `buf`, rebuilding it first if needed.
+// Returns the number of bytes copied, which is less than `len` at the end of the image or on error.
+size_t ndef_image_read_at(ndef_image img, size_t offset, uint8_t *buf, size_t len) {
+	if (!ndef_image_update(img)) return 0;
+	if (offset >= img->len) return 0;
+	if (len > img->len - offset) len = img->len - offset;
+	
+	// Copy from the segments in turn.
+	size_t seg  = find_seg(img, offset);
+	size_t done = 0;
+	while (done < len) {
+		const ndef_image_seg *cur = img->segs + seg;
+		size_t skip  = offset + done - cur->offset;
+		size_t avail = cur->len - skip;
+		if (avail > len - done) avail = len - done;
+		memcpy(buf + done, cur->data + skip, avail);
+		done += avail;
+		if (skip + avail == cur->len && seg + 1 < img->segs_len) seg ++;
+	}
+	img->cursor = seg;
+	
+	return len;
+}
+
+// Get the reason the last operation on the image failed, or `NDEF_OK`.
+ndef_err ndef_image_get_error(ndef_image img) {
+	return img->error;
+}
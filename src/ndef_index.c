@@ -0,0 +1,249 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#define NDEF_REVEAL_PRIVATE
+#include "ndef_index.h"
+#include "ndef_record_types.h"
+#include "ndef_log.h"
+
+
+
+// Marks the end of a hash chain.
+#define CHAIN_END ((ndef_index_t) -1)
+
+// Field lengths of a raw record, from its header.
+typedef struct {
+	// Flags byte.
+	uint8_t flags;
+	// Length of the header.
+	size_t  header_len;
+	// Length of the type field.
+	size_t  type_len;
+	// Length of the payload field.
+	size_t  payload_len;
+	// Length of the ID field.
+	size_t  id_len;
+} raw_header;
+
+// Read the header of a raw record that is known to be valid.
+static raw_header read_header(const uint8_t *data) {
+	raw_header hdr = { .flags = data[0] };
+	size_t pos = 1;
+	hdr.type_len = data[pos++];
+	if (hdr.flags & NDEF_FLAG_SR) {
+		hdr.payload_len = data[pos++];
+	} else {
+		hdr.payload_len  = (size_t) data[pos++] << 24;
+		hdr.payload_len |= (size_t) data[pos++] << 16;
+		hdr.payload_len |= (size_t) data[pos++] <<  8;
+		hdr.payload_len |= (size_t) data[pos++] <<  0;
+	}
+	if (hdr.flags & NDEF_FLAG_IL) hdr.id_len = data[pos++];
+	hdr.header_len = pos;
+	return hdr;
+}
+
+// Determine the total length of a raw record from its header.
+static inline size_t raw_len(raw_header hdr) {
+	return hdr.header_len + hdr.type_len + hdr.payload_len + hdr.id_len;
+}
+
+// FNV-1a hash of a type or ID, which is prefixed with `prefix` to tell TNFs apart.
+static uint32_t hash(uint8_t prefix, const uint8_t *data, size_t len) {
+	uint32_t h = (2166136261u ^ prefix) * 16777619u;
+	for (size_t i = 0; i < len; i++) {
+		h = (h ^ data[i]) * 16777619u;
+	}
+	return h;
+}
+
+
+
+// Index the records in a blob of NDEF data, which must outlive the index.
+// Only reads the record headers; returns NULL if the data is not a valid message or out of memory.
+ndef_index ndef_index_build(uint8_t *data, size_t len) {
+	// Count the records first so everything fits in one allocation.
+	ndef_validate_info info;
+	if (!data || ndef_validate(data, len, &info)) return NULL;
+	size_t buckets = 1;
+	while (buckets < info.records) buckets *= 2;
+	
+	size_t size = sizeof(ndef_index_s)
+		+ sizeof(ndef_index_entry) * info.records
+		+ sizeof(ndef_index_t) * buckets * 2;
+	ndef_index idx = ndef_malloc(size, NDEF_ALLOC_ARRAY);
+	if (!idx) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", size);
+		return NULL;
+	}
+	idx->data         = data;
+	idx->records_len  = info.records;
+	idx->records      = (ndef_index_entry *) (idx + 1);
+	idx->buckets_len  = buckets;
+	idx->type_buckets = (ndef_index_t *) (idx->records + info.records);
+	idx->id_buckets   = idx->type_buckets + buckets;
+	for (size_t i = 0; i < buckets; i++) {
+		idx->type_buckets[i] = CHAIN_END;
+		idx->id_buckets[i]   = CHAIN_END;
+	}
+	
+	// Locate the records.
+	size_t pos = 0;
+	for (size_t i = 0; i < info.records; i++) {
+		ndef_index_entry *ent = idx->records + i;
+		raw_header        hdr = read_header(data + pos);
+		*ent = (ndef_index_entry) {
+			.offset   = pos,
+			.tnf      = hdr.flags & NDEF_FLAG_TNF,
+			.type_len = hdr.type_len,
+			.id_len   = hdr.id_len,
+		};
+		
+		// Add up the chunks.
+		size_t non_empty = 0;
+		while (1) {
+			if (hdr.payload_len) {
+				ent->payload_offset = pos + hdr.header_len + hdr.type_len;
+				non_empty ++;
+			}
+			ent->payload_len += hdr.payload_len;
+			ent->raw_len     ++;
+			pos              += raw_len(hdr);
+			if (!(hdr.flags & NDEF_FLAG_CF)) break;
+			hdr = read_header(data + pos);
+		}
+		if (non_empty > 1) ent->payload_offset = 0;
+		ent->len = pos - ent->offset;
+	}
+	
+	// Fill the hash buckets back to front, so the chains are in ascending order.
+	for (size_t i = info.records; i-- > 0;) {
+		ndef_index_entry *ent  = idx->records + i;
+		raw_header        hdr  = read_header(data + ent->offset);
+		const uint8_t    *type = data + ent->offset + hdr.header_len;
+		const uint8_t    *id   = type + hdr.type_len + hdr.payload_len;
+		
+		uint32_t bucket = hash(ent->tnf, type, ent->type_len) & (buckets - 1);
+		ent->type_next  = idx->type_buckets[bucket];
+		idx->type_buckets[bucket] = i;
+		
+		ent->id_next = CHAIN_END;
+		if (ent->id_len) {
+			bucket        = hash(0, id, ent->id_len) & (buckets - 1);
+			ent->id_next  = idx->id_buckets[bucket];
+			idx->id_buckets[bucket] = i;
+		}
+	}
+	
+	return idx;
+}
+
+// Destroy an index.
+void ndef_index_destroy(ndef_index idx) {
+	ndef_free(idx, NDEF_ALLOC_ARRAY);
+}
+
+// Get the number of records in the index.
+size_t ndef_index_len(ndef_index idx) {
+	return idx->records_len;
+}
+
+// Get the location and size of record `n`, or NULL if out of range.
+const ndef_index_entry *ndef_index_entry_get(ndef_index idx, size_t n) {
+	return n < idx->records_len ? idx->records + n : NULL;
+}
+
+// Get a view of record `n` without decoding the rest of the message.
+// The fields point into the indexed data. If the payload is split over multiple chunks, `payload` is NULL,
+// `payload_len` is 0 and the kind is `NDEF_KIND_OTHER`; use `ndef_index_read_payload` to join it.
+// Returns false if `n` is out of range.
+bool ndef_index_get(ndef_index idx, size_t n, ndef_record *out) {
+	if (n >= idx->records_len) return false;
+	const ndef_index_entry *ent = idx->records + n;
+	raw_header hdr = read_header(idx->data + ent->offset);
+	
+	ndef_record tmp = ndef_record_init();
+	tmp.tnf         = ent->tnf;
+	tmp.borrowed    = NDEF_BORROW_ALL;
+	tmp.type_len    = ent->type_len;
+	tmp.type        = ent->type_len ? idx->data + ent->offset + hdr.header_len : NULL;
+	tmp.payload_len = ent->payload_len;
+	tmp.payload     = ent->payload_offset ? idx->data + ent->payload_offset : NULL;
+	tmp.id_len      = ent->id_len;
+	tmp.id          = ent->id_len ? idx->data + ent->offset + hdr.header_len + hdr.type_len + hdr.payload_len : NULL;
+	if (tmp.payload_len && !tmp.payload) {
+		// A split payload can't be viewed in place, so neither can its contents.
+		tmp.payload_len = 0;
+		tmp.kind        = NDEF_KIND_OTHER;
+	} else {
+		tmp.kind        = ndef_classify(tmp);
+	}
+	
+	*out = tmp;
+	return true;
+}
+
+// Copy the payload of record `n` into `buf`, joining chunks if needed.
+// Returns the payload length, which is copied only if `cap` is large enough.
+size_t ndef_index_read_payload(ndef_index idx, size_t n, uint8_t *buf, size_t cap) {
+	if (n >= idx->records_len) return 0;
+	const ndef_index_entry *ent = idx->records + n;
+	if (cap < ent->payload_len) return ent->payload_len;
+	
+	size_t pos = ent->offset, copied = 0;
+	for (size_t i = 0; i < ent->raw_len; i++) {
+		raw_header hdr = read_header(idx->data + pos);
+		memcpy(buf + copied, idx->data + pos + hdr.header_len + hdr.type_len, hdr.payload_len);
+		copied += hdr.payload_len;
+		pos    += raw_len(hdr);
+	}
+	return ent->payload_len;
+}
+
+// Find the first record at or after `start` with the given TNF and type.
+// Returns `NDEF_INDEX_NONE` if there is none.
+size_t ndef_index_find_type(ndef_index idx, ndef_tnf tnf, const uint8_t *type, size_t type_len, size_t start) {
+	uint32_t bucket = hash(tnf, type, type_len) & (idx->buckets_len - 1);
+	for (ndef_index_t i = idx->type_buckets[bucket]; i != CHAIN_END; i = idx->records[i].type_next) {
+		const ndef_index_entry *ent = idx->records + i;
+		if (i < start || ent->tnf != tnf || ent->type_len != type_len) continue;
+		raw_header hdr = read_header(idx->data + ent->offset);
+		if (!memcmp(idx->data + ent->offset + hdr.header_len, type, type_len)) return i;
+	}
+	return NDEF_INDEX_NONE;
+}
+
+// Find the first record at or after `start` with the given ID.
+// Returns `NDEF_INDEX_NONE` if there is none.
+size_t ndef_index_find_id(ndef_index idx, const uint8_t *id, size_t id_len, size_t start) {
+	if (!id_len) return NDEF_INDEX_NONE;
+	uint32_t bucket = hash(0, id, id_len) & (idx->buckets_len - 1);
+	for (ndef_index_t i = idx->id_buckets[bucket]; i != CHAIN_END; i = idx->records[i].id_next) {
+		const ndef_index_entry *ent = idx->records + i;
+		if (i < start || ent->id_len != id_len) continue;
+		raw_header hdr = read_header(idx->data + ent->offset);
+		if (!memcmp(idx->data + ent->offset + hdr.header_len + hdr.type_len + hdr.payload_len, id, id_len)) return i;
+	}
+	return NDEF_INDEX_NONE;
+}
@@ -0,0 +1,115 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "ndef_record_types.h"
+#include "ndef_log.h"
+
+
+
+// Hash function used to find record types in the registry.
+#define TYPE_HASH(tnf, type_len, first, last) (((tnf) * 9 + (type_len) * 5 + (first) + (last) * 3) % TYPE_BUCKETS)
+// Number of hash buckets in the registry.
+#define TYPE_BUCKETS 32
+
+static const ndef_type_handler uri_handler = {
+	NDEF_TNF_WELL_KNOWN, 1, (const uint8_t *) "U",  2, "URI",
+};
+static const ndef_type_handler text_handler = {
+	NDEF_TNF_WELL_KNOWN, 1, (const uint8_t *) "T",  4, "Text",
+};
+static const ndef_type_handler smartposter_handler = {
+	NDEF_TNF_WELL_KNOWN, 2, (const uint8_t *) "Sp", 1, "Smart poster",
+};
+
+// Registered handlers by kind.
+static const ndef_type_handler *handlers[NDEF_KIND_MAX] = {
+	[NDEF_KIND_URI]         = &uri_handler,
+	[NDEF_KIND_TEXT]        = &text_handler,
+	[NDEF_KIND_SMARTPOSTER] = &smartposter_handler,
+};
+// Number of kinds in use.
+static uint8_t kinds_len = NDEF_KIND_USER;
+
+// First kind in each hash bucket.
+static uint8_t buckets[TYPE_BUCKETS] = {
+	[TYPE_HASH(NDEF_TNF_WELL_KNOWN, 1, 'U', 'U')] = NDEF_KIND_URI,
+	[TYPE_HASH(NDEF_TNF_WELL_KNOWN, 1, 'T', 'T')] = NDEF_KIND_TEXT,
+	[TYPE_HASH(NDEF_TNF_WELL_KNOWN, 2, 'S', 'p')] = NDEF_KIND_SMARTPOSTER,
+};
+// Next kind in the same hash bucket.
+static uint8_t bucket_next[NDEF_KIND_MAX];
+
+
+
+// Determine the hash bucket for a record type.
+static inline uint_fast8_t type_hash(ndef_tnf tnf, uint8_t type_len, const uint8_t *type) {
+	if (!type_len) return TYPE_HASH(tnf, 0, 0, 0);
+	return TYPE_HASH(tnf, type_len, type[0], type[type_len - 1]);
+}
+
+// Find the kind registered for a record type, or 0 if there is none.
+static uint8_t find(ndef_tnf tnf, uint8_t type_len, const uint8_t *type) {
+	for (uint8_t kind = buckets[type_hash(tnf, type_len, type)]; kind; kind = bucket_next[kind]) {
+		const ndef_type_handler *handler = handlers[kind];
+		if (handler->tnf == tnf && handler->type_len == type_len && !memcmp(handler->type, type, type_len)) {
+			return kind;
+		}
+	}
+	return 0;
+}
+
+// Register a record type with the type registry.
+// `handler` must remain valid forever. Not thread-safe; register types before decoding.
+// Returns the kind for the type, or `NDEF_KIND_OTHER` if the registry is full.
+uint8_t ndef_register_type(const ndef_type_handler *handler) {
+	// Types can only be registered once.
+	uint8_t kind = find(handler->tnf, handler->type_len, handler->type);
+	if (kind) return kind;
+	
+	if (kinds_len >= NDEF_KIND_MAX) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Too many record types registered");
+		return NDEF_KIND_OTHER;
+	}
+	
+	// Add to the front of the bucket.
+	kind = kinds_len++;
+	uint_fast8_t hash = type_hash(handler->tnf, handler->type_len, handler->type);
+	handlers[kind]    = handler;
+	bucket_next[kind] = buckets[hash];
+	buckets[hash]     = kind;
+	
+	return kind;
+}
+
+// Get the registered handler for a kind, or NULL if there is none.
+const ndef_type_handler *ndef_kind_handler(uint8_t kind) {
+	return kind < NDEF_KIND_MAX ? handlers[kind] : NULL;
+}
+
+// Look up the kind of an NDEF record in the type registry.
+uint8_t ndef_classify(ndef_record ctx) {
+	uint8_t kind = find(ctx.tnf, ctx.type_len, ctx.type);
+	if (!kind || ctx.payload_len < handlers[kind]->min_payload_len) return NDEF_KIND_OTHER;
+	return kind;
+}
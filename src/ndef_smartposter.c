@@ -22,37 +22,80 @@
 	SOFTWARE.
 */
 
+#define NDEF_REVEAL_PRIVATE
 #include "ndef_smartposter.h"
 #include "ndef_uri.h"
+#include "ndef_record_types.h"
 
 
 
 // Determine whether an NDEF record is a text record.
 bool ndef_record_is_smartposter(ndef_record ctx) {
-	return ctx.tnf == NDEF_TNF_WELL_KNOWN && ctx.type_len == 2 && ctx.payload_len && ctx.type[0] == 'S' && ctx.type[1] == 'p';
+	return ndef_record_kind(ctx) == NDEF_KIND_SMARTPOSTER;
+}
+
+// Find the first URI and text records in a smart poster record without decoding or copying it.
+// Returns false when not a smart poster record.
+bool ndef_record_get_smartposter_view(ndef_record ctx, ndef_smartposter_view *out) {
+	if (!ndef_record_is_smartposter(ctx)) return false;
+	// The payload may be missing, e.g. in an index view of a chunked record.
+	if (!ctx.payload && ctx.payload_len) return false;
+	*out = (ndef_smartposter_view) {
+		.data     = ctx.payload,
+		.data_len = ctx.payload_len,
+	};
+	
+	// Walk the inner records in place until both are found.
+	size_t pos = 0;
+	while (pos < ctx.payload_len && (!out->has_uri || !out->has_text)) {
+		ndef_raw_record record;
+		size_t record_len = ctx.payload_len - pos;
+		if (!ndef_raw_record_decode_view(&record, ctx.payload + pos, &record_len)) break;
+		pos += record_len;
+		
+		// Chunked records can't be inspected in place.
+		if (record.flag_chunked || record.tnf == NDEF_TNF_UNCHANGED) continue;
+		
+		// Classify the record once; the views below reuse its kind.
+		uint8_t kind = ndef_classify(record.abstract);
+		record.abstract.kind = kind;
+		if (!out->has_uri && kind == NDEF_KIND_URI) {
+			out->uri_record = record.abstract;
+			out->has_uri    = ndef_record_get_uri_view(record.abstract, &out->uri);
+		} else if (!out->has_text && kind == NDEF_KIND_TEXT) {
+			out->text_record = record.abstract;
+			out->has_text    = ndef_record_get_text_view(record.abstract, &out->text);
+		}
+	}
+	
+	return true;
+}
+
+// Decode the inner NDEF message of a smart poster view.
+// The records borrow their data from the smart poster record, which must outlive the context.
+ndef_ctx ndef_smartposter_view_decode(const ndef_smartposter_view *view) {
+	size_t len = view->data_len;
+	return ndef_decode_view(view->data, &len);
 }
 
 // Construct a `ndef_smartposter` containing a summary containing the payload NDEF, URI (if present) and text (if present).
 // Returns NULL when out of memory, or when not a smart poster record.
 ndef_smartposter ndef_record_get_smartposter(ndef_record ctx) {
 	ndef_smartposter out = ndef_smartposter_init();
+	ndef_smartposter_view view;
+	if (!ndef_record_get_smartposter_view(ctx, &view)) return out;
 	
-	// Decode inner NDEF.
-	size_t payload_len = ctx.payload_len;
-	out.ndef = ndef_decode(ctx.payload, &payload_len);
+	// The view walk already found the URI and text; the inner NDEF is only copied once, into one arena.
+	size_t payload_len = view.data_len;
+	out.ndef = ndef_decode_arena(view.data, &payload_len);
+	if (!out.ndef) return out;
 	
-	// Look for URI record.
-	for (size_t i = 0; i < ndef_records_len(out.ndef); i++) {
-		ndef_record record = ndef_records(out.ndef)[i];
-		out.uri = ndef_record_get_uri(record);
-		if (out.uri) break;
+	// Copy the first URI and text records.
+	if (view.has_uri) {
+		out.uri = ndef_record_get_uri(view.uri_record);
 	}
-	
-	// Look for text record.
-	for (size_t i = 0; i < ndef_records_len(out.ndef); i++) {
-		ndef_record record = ndef_records(out.ndef)[i];
-		out.text = ndef_record_get_text(record);
-		if (out.text.lang) break;
+	if (view.has_text) {
+		out.text = ndef_record_get_text(view.text_record);
 	}
 	
 	return out;
@@ -67,13 +110,14 @@ ndef_record ndef_record_new_smartposter(ndef_smartposter ctx) {
 	} else {
 		ctx.ndef = ndef_clone(ctx.ndef);
 	}
+	if (!ctx.ndef) return ndef_record_init();
 	
 	// Check for URI and text records.
 	bool has_uri = false, has_text = false;
 	for (size_t i = 0; i < ndef_records_len(ctx.ndef); i++) {
 		ndef_record record = ndef_records(ctx.ndef)[i];
-		has_uri  |= ndef_record_is_uri (record);
-		has_text |= ndef_record_is_text(record);
+		has_uri  |= record.kind == NDEF_KIND_URI;
+		has_text |= record.kind == NDEF_KIND_TEXT;
 	}
 	
 	// Append URI record.
@@ -86,16 +130,20 @@ ndef_record ndef_record_new_smartposter(ndef_smartposter ctx) {
 		ndef_append_mv(ctx.ndef, ndef_record_new_text(ctx.text));
 	}
 	
-	// Encode NDEF data.
-	size_t len;
-	uint8_t *data;
-	ndef_encode(ctx.ndef, &data, &len);
+	// Encode NDEF data straight into the payload.
+	size_t   len  = ndef_encode_size(ctx.ndef);
+	uint8_t *data = len ? ndef_malloc(len, NDEF_ALLOC_PAYLOAD) : NULL;
+	if (len && (!data || !ndef_encode_into(ctx.ndef, data, len, &len))) {
+		ndef_free(data, NDEF_ALLOC_PAYLOAD);
+		ndef_destroy(ctx.ndef);
+		return ndef_record_init();
+	}
 	ndef_destroy(ctx.ndef);
 	
 	// Construct type.
-	uint8_t *type = malloc(2);
+	uint8_t *type = ndef_malloc(2, NDEF_ALLOC_FIELD);
 	if (!type) {
-		free(data);
+		ndef_free(data, NDEF_ALLOC_PAYLOAD);
 		return ndef_record_init();
 	}
 	type[0] = 'S';
@@ -104,7 +152,8 @@ ndef_record ndef_record_new_smartposter(ndef_smartposter ctx) {
 	// Construct record.
 	return (ndef_record) {
 		.tnf			= NDEF_TNF_WELL_KNOWN,
-		.type_len		= 1,
+		.kind			= NDEF_KIND_SMARTPOSTER,
+		.type_len		= 2,
 		.payload_len	= len,
 		.id_len			= 0,
 		.type			= type,
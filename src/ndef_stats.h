@@ -0,0 +1,57 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+
+#include "ndef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#ifdef NDEF_ENABLE_STATS
+// Enter a phase on the current thread.
+void ndef_stats_begin(ndef_phase phase);
+// Leave a phase on the current thread.
+void ndef_stats_end(ndef_phase phase);
+// Count an allocation of `bytes` bytes against the current thread's phase.
+void ndef_stats_alloc(size_t bytes);
+// Enter a phase.
+#define NDEF_PHASE_BEGIN(phase) ndef_stats_begin(phase)
+// Leave a phase.
+#define NDEF_PHASE_END(phase)   ndef_stats_end(phase)
+// Count an allocation.
+#define NDEF_STATS_ALLOC(bytes) ndef_stats_alloc(bytes)
+#else
+// Statistics are compiled out.
+#define NDEF_PHASE_BEGIN(phase) ((void) 0)
+#define NDEF_PHASE_END(phase)   ((void) 0)
+#define NDEF_STATS_ALLOC(bytes) ((void) 0)
+#endif
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
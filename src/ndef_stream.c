@@ -0,0 +1,226 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#define NDEF_REVEAL_PRIVATE
+#include "ndef_stream.h"
+#include "ndef_log.h"
+
+
+
+// Determine the length of a record header from its flags byte.
+static inline size_t header_len(uint8_t flags) {
+	return 2 + (flags & NDEF_FLAG_SR ? 1 : 4) + (flags & NDEF_FLAG_IL ? 1 : 0);
+}
+
+// Determine the total length of a record from its complete header.
+// Returns false if the length does not fit in a `size_t`.
+static bool record_len(const uint8_t *header, size_t *out) {
+	size_t pos = 1;
+	size_t len = header_len(header[0]);
+	
+	// Type length.
+	len += header[pos++];
+	
+	// Payload length.
+	uint32_t payload_len;
+	if (header[0] & NDEF_FLAG_SR) {
+		payload_len  = header[pos++];
+	} else {
+		payload_len  = (uint32_t) header[pos++] << 24;
+		payload_len |= (uint32_t) header[pos++] << 16;
+		payload_len |= (uint32_t) header[pos++] <<  8;
+		payload_len |= (uint32_t) header[pos++] <<  0;
+	}
+	
+	// ID length.
+	if (header[0] & NDEF_FLAG_IL) {
+		len += header[pos++];
+	}
+	
+	if (payload_len > SIZE_MAX - len) return false;
+	*out = len + payload_len;
+	return true;
+}
+
+// Determine the total length of a record from its complete header, stopping the parser if it is too long.
+static bool check_record_len(ndef_parser ctx, const uint8_t *header, size_t *out) {
+	if (record_len(header, out)) return true;
+	NDEF_LOG(NDEF_LOG_ERROR, "Error: Record is too long to buffer (does not fit in size_t)");
+	ctx->status = NDEF_PARSER_ERROR;
+	ctx->error  = NDEF_ERR_TOO_LONG;
+	return false;
+}
+
+// Make sure the record buffer has a capacity of at least `cap` bytes, growing it geometrically.
+static bool reserve(ndef_parser ctx, size_t cap) {
+	if (ctx->buf_cap >= cap) return true;
+	size_t grown = ctx->buf_cap ? ctx->buf_cap : 8;
+	while (grown < cap && grown <= SIZE_MAX / 2) grown *= 2;
+	if (grown > cap) cap = grown;
+	void *mem = ndef_realloc(ctx->buf, cap, NDEF_ALLOC_PAYLOAD);
+	if (!mem) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", cap);
+		ctx->error = NDEF_ERR_NO_MEM;
+		return false;
+	}
+	ctx->buf     = mem;
+	ctx->buf_cap = cap;
+	return true;
+}
+
+// Decode a complete record and pass it to the callback.
+static void emit(ndef_parser ctx, const uint8_t *data, size_t len) {
+	ndef_raw_record record;
+	if (!ndef_raw_record_decode_view(&record, (uint8_t *) data, &len)) {
+		ctx->status = NDEF_PARSER_ERROR;
+		ctx->error  = NDEF_ERR_TRUNCATED;
+	} else if (!ctx->cb(ctx->cookie, &record)) {
+		ctx->status = NDEF_PARSER_STOPPED;
+	} else if (record.flag_end) {
+		ctx->status = NDEF_PARSER_DONE;
+	}
+}
+
+
+
+// Create an incremental parser that calls `cb` for every complete record.
+ndef_parser ndef_parser_init(ndef_parser_cb cb, void *cookie) {
+	if (!cb) return NULL;
+	
+	ndef_parser out = ndef_malloc(sizeof(ndef_parser_s), NDEF_ALLOC_ARRAY);
+	if (out) *out = (ndef_parser_s) {
+		cb, cookie, NDEF_PARSER_MORE, NDEF_OK,
+		NULL, 0, 0, 0,
+		0,
+	};
+	
+	return out;
+}
+
+// Destroy an incremental parser.
+void ndef_parser_destroy(ndef_parser ctx) {
+	if (ctx->buf) ndef_free(ctx->buf, NDEF_ALLOC_PAYLOAD);
+	ndef_free(ctx, NDEF_ALLOC_ARRAY);
+}
+
+// Reset an incremental parser to start parsing a new message.
+// Keeps the record buffer for reuse.
+void ndef_parser_reset(ndef_parser ctx) {
+	ctx->status     = NDEF_PARSER_MORE;
+	ctx->error      = NDEF_OK;
+	ctx->buf_len    = 0;
+	ctx->record_len = 0;
+	ctx->offset     = 0;
+}
+
+// Feed a chunk of NDEF data into the parser.
+// Sets `len` to the amount of data consumed, which is less than given only when parsing stops.
+ndef_parser_status ndef_parser_feed(ndef_parser ctx, const uint8_t *data, size_t *len) {
+	size_t pos = 0;
+	
+	while (pos < *len && ctx->status == NDEF_PARSER_MORE) {
+		size_t remaining = *len - pos;
+		
+		// Records that arrive in one piece are parsed in place.
+		if (!ctx->buf_len) {
+			size_t hlen = header_len(data[pos]);
+			if (remaining >= hlen) {
+				size_t rlen;
+				if (!check_record_len(ctx, data + pos, &rlen)) break;
+				if (remaining >= rlen) {
+					emit(ctx, data + pos, rlen);
+					pos += rlen;
+					continue;
+				}
+			}
+		}
+		
+		// Determine how much more of the current record can be buffered.
+		size_t target;
+		if (ctx->record_len) {
+			target = ctx->record_len;
+		} else if (ctx->buf_len) {
+			target = header_len(ctx->buf[0]);
+		} else {
+			target = 1;
+		}
+		size_t copy = target - ctx->buf_len;
+		if (copy > remaining) copy = remaining;
+		
+		// Buffer the record data.
+		if (!reserve(ctx, ctx->buf_len + copy)) {
+			ctx->status = NDEF_PARSER_ERROR;
+			break;
+		}
+		memcpy(ctx->buf + ctx->buf_len, data + pos, copy);
+		ctx->buf_len += copy;
+		pos          += copy;
+		
+		// Advance to the next part of the record.
+		if (ctx->buf_len < target) continue;
+		if (!ctx->record_len && ctx->buf_len >= header_len(ctx->buf[0])) {
+			if (!check_record_len(ctx, ctx->buf, &ctx->record_len)) break;
+			// Make room for the rest of the record at once.
+			if (!reserve(ctx, ctx->record_len)) {
+				ctx->status = NDEF_PARSER_ERROR;
+				break;
+			}
+		}
+		if (ctx->record_len && ctx->buf_len == ctx->record_len) {
+			emit(ctx, ctx->buf, ctx->buf_len);
+			ctx->buf_len    = 0;
+			ctx->record_len = 0;
+		}
+	}
+	
+	ctx->offset += pos;
+	*len = pos;
+	return ctx->status;
+}
+
+// Get the current state of the parser.
+ndef_parser_status ndef_parser_get_status(ndef_parser ctx) {
+	return ctx->status;
+}
+
+// Get the reason the parser is in the `NDEF_PARSER_ERROR` state, or `NDEF_OK`.
+// The error occurred at `ndef_parser_offset`.
+ndef_err ndef_parser_get_error(ndef_parser ctx) {
+	return ctx->error;
+}
+
+// Get the minimum number of bytes required before the next record can complete.
+// Returns 0 if the parser will not accept more data.
+size_t ndef_parser_needed(ndef_parser ctx) {
+	if (ctx->status != NDEF_PARSER_MORE) return 0;
+	if (ctx->record_len) return ctx->record_len - ctx->buf_len;
+	if (ctx->buf_len) return header_len(ctx->buf[0]) - ctx->buf_len;
+	// The shortest possible record is three bytes.
+	return 3;
+}
+
+// Get the total amount of data consumed since the start of the message.
+size_t ndef_parser_offset(ndef_parser ctx) {
+	return ctx->offset;
+}
@@ -0,0 +1,355 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#define NDEF_REVEAL_PRIVATE
+#include "ndef_tag.h"
+#include "ndef_log.h"
+
+
+
+// Type 2 TLV: padding without a length.
+#define TLV_NULL       0x00
+// Type 2 TLV: the NDEF message.
+#define TLV_NDEF       0x03
+// Type 2 TLV: end of the TLV area.
+#define TLV_TERMINATOR 0xFE
+// Type 4 CC TLV: NDEF file control with a 2-byte size.
+#define TLV_T4_FILE    0x04
+// Type 4 CC TLV: extended NDEF file control with a 4-byte size.
+#define TLV_T4_EFILE   0x06
+
+// Offset of the capability container of a Type 2 tag.
+#define T2_CC_OFFSET   12
+// Offset of the TLV area of a Type 2 tag.
+#define T2_DATA_OFFSET 16
+// Length of a Type 4 capability container up to the end of the NDEF file control TLV.
+#define T4_CC_LEN      15
+// Length of a Type 4 capability container up to the end of the extended NDEF file control TLV.
+#define T4_CC_MAX_LEN  17
+
+
+
+// Note down why an operation on `ctx` failed.
+// Always returns false.
+static bool fail(ndef_tag ctx, ndef_err error) {
+	ctx->error = error;
+	return false;
+}
+
+// Get a pointer to tag memory at `offset` in `file`, reading it if it is not cached.
+// Never reads past `end` for Type 4 tags, where reads that go out of bounds fail.
+// Sets `avail` to the number of bytes available from the pointer, or returns NULL on error.
+static const uint8_t *fetch(ndef_tag ctx, uint16_t file, size_t offset, size_t end, size_t *avail) {
+	// Use the cached block if it has the data.
+	if (ctx->cache_len && ctx->cache_file == file
+		&& offset >= ctx->cache_offset && offset < ctx->cache_offset + ctx->cache_len) {
+		*avail = ctx->cache_offset + ctx->cache_len - offset;
+		return ctx->cache + offset - ctx->cache_offset;
+	}
+	
+	// Work out which block to read.
+	size_t start, len;
+	if (ctx->type == NDEF_TAG_TYPE2) {
+		start = offset - offset % ctx->block_size;
+		len   = ctx->block_size;
+	} else {
+		start = offset;
+		len   = end - offset;
+		if (len > ctx->block_size) len = ctx->block_size;
+	}
+	
+	ctx->cache_len = 0;
+	if (!ctx->read(ctx->cookie, file, start, ctx->cache, len)) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Tag read failed (file 0x%04x, %zu bytes at offset %zu)", file, len, start);
+		fail(ctx, NDEF_ERR_READ);
+		return NULL;
+	}
+	ctx->cache_file   = file;
+	ctx->cache_offset = start;
+	ctx->cache_len    = len;
+	*avail = start + len - offset;
+	return ctx->cache + offset - start;
+}
+
+// Read `len` bytes of tag memory at `offset` in `file`, going through the cache.
+static bool read_bytes(ndef_tag ctx, uint16_t file, size_t offset, size_t end, uint8_t *out, size_t len) {
+	while (len) {
+		size_t avail;
+		const uint8_t *data = fetch(ctx, file, offset, end, &avail);
+		if (!data) return false;
+		if (avail > len) avail = len;
+		memcpy(out, data, avail);
+		out    += avail;
+		offset += avail;
+		len    -= avail;
+	}
+	return true;
+}
+
+
+
+// Create a reader for tag memory accessed through `read`.
+ndef_tag ndef_tag_init(ndef_tag_type type, ndef_tag_read_cb read, void *cookie) {
+	if (!read) return NULL;
+	
+	ndef_tag out = ndef_malloc(sizeof(ndef_tag_s), NDEF_ALLOC_ARRAY);
+	if (!out) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", sizeof(ndef_tag_s));
+		return NULL;
+	}
+	out->type         = type;
+	out->read         = read;
+	out->cookie       = cookie;
+	out->block_size   = type == NDEF_TAG_TYPE2 ? NDEF_TAG_T2_BLOCK_SIZE : NDEF_TAG_CACHE_SIZE;
+	out->error        = NDEF_OK;
+	out->cache_file   = 0;
+	out->cache_offset = 0;
+	out->cache_len    = 0;
+	if (out->block_size > NDEF_TAG_CACHE_SIZE) out->block_size = NDEF_TAG_CACHE_SIZE;
+	
+	return out;
+}
+
+// Destroy a tag reader.
+void ndef_tag_destroy(ndef_tag ctx) {
+	ndef_free(ctx, NDEF_ALLOC_ARRAY);
+}
+
+// Set the maximum number of bytes per read, up to `NDEF_TAG_CACHE_SIZE`.
+// For Type 4 tags this is lowered further to the MLe from the capability container.
+void ndef_tag_set_block_size(ndef_tag ctx, size_t block_size) {
+	if (!block_size) return;
+	if (block_size > NDEF_TAG_CACHE_SIZE) block_size = NDEF_TAG_CACHE_SIZE;
+	ctx->block_size = block_size;
+	ctx->cache_len  = 0;
+}
+
+// Forget cached tag memory, e.g. after the tag was written or replaced.
+void ndef_tag_invalidate(ndef_tag ctx) {
+	ctx->cache_len = 0;
+}
+
+// Get the reason the last operation on the tag failed, or `NDEF_OK`.
+ndef_err ndef_tag_get_error(ndef_tag ctx) {
+	return ctx->error;
+}
+
+
+
+// Find the NDEF TLV of a Type 2 tag.
+static bool locate_t2(ndef_tag ctx, ndef_tag_info *out) {
+	// Check the capability container.
+	uint8_t cc[4];
+	if (!read_bytes(ctx, 0, T2_CC_OFFSET, T2_DATA_OFFSET, cc, sizeof(cc))) return false;
+	if (cc[0] != 0xE1 || (cc[1] >> 4) > 1) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Not an NDEF formatted Type 2 tag (CC %02x %02x %02x %02x)", cc[0], cc[1], cc[2], cc[3]);
+		return fail(ctx, NDEF_ERR_INVALID);
+	}
+	if (cc[3] >> 4) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Tag does not allow reading (access 0x%02x)", cc[3]);
+		return fail(ctx, NDEF_ERR_INVALID);
+	}
+	size_t end    = T2_DATA_OFFSET + cc[2] * 8;
+	out->file     = 0;
+	out->writable = (cc[3] & 0x0F) == 0;
+	
+	// Walk the TLVs until the NDEF TLV.
+	size_t pos = T2_DATA_OFFSET;
+	while (pos < end) {
+		uint8_t tag;
+		if (!read_bytes(ctx, 0, pos, end, &tag, 1)) return false;
+		if (tag == TLV_NULL) {
+			pos ++;
+			continue;
+		} else if (tag == TLV_TERMINATOR) {
+			break;
+		}
+		
+		// One-byte length, or 0xFF followed by a two-byte length.
+		uint8_t lbuf[3];
+		size_t  hlen = 2;
+		if (pos + 2 > end || !read_bytes(ctx, 0, pos + 1, end, lbuf, 1)) break;
+		size_t len = lbuf[0];
+		if (len == 0xFF) {
+			hlen = 4;
+			if (pos + 4 > end || !read_bytes(ctx, 0, pos + 2, end, lbuf + 1, 2)) break;
+			len = (lbuf[1] << 8) | lbuf[2];
+		}
+		
+		if (tag == TLV_NDEF) {
+			if (pos + hlen + len > end) {
+				NDEF_LOG(NDEF_LOG_ERROR, "Error: NDEF TLV is longer than the data area (%zu bytes at offset %zu)", len, pos);
+				return fail(ctx, NDEF_ERR_TRUNCATED);
+			}
+			out->offset   = pos + hlen;
+			out->len      = len;
+			out->capacity = end - out->offset;
+			return true;
+		}
+		pos += hlen + len;
+	}
+	
+	if (ctx->error) return false;
+	NDEF_LOG(NDEF_LOG_ERROR, "Error: No NDEF TLV found");
+	return fail(ctx, NDEF_ERR_INVALID);
+}
+
+// Find the NDEF file of a Type 4 tag.
+static bool locate_t4(ndef_tag ctx, ndef_tag_info *out) {
+	// Read the capability container, which is at least long enough for a plain NDEF file control TLV.
+	uint8_t cc[T4_CC_MAX_LEN];
+	if (!read_bytes(ctx, NDEF_TAG_T4_CC_FILE, 0, T4_CC_LEN, cc, T4_CC_LEN)) return false;
+	size_t cc_len = (cc[0] << 8) | cc[1];
+	size_t mle    = (cc[3] << 8) | cc[4];
+	if (cc_len < T4_CC_LEN || (cc[2] >> 4) < 2 || (cc[2] >> 4) > 3 || mle < 0x0F) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Invalid Type 4 capability container (length %zu, version 0x%02x, MLe %zu)", cc_len, cc[2], mle);
+		return fail(ctx, NDEF_ERR_INVALID);
+	}
+	if (mle < ctx->block_size) ctx->block_size = mle;
+	
+	// The extended NDEF file control TLV is two bytes longer.
+	size_t tlv_len = T4_CC_LEN;
+	if (cc[7] == TLV_T4_EFILE && cc_len >= T4_CC_MAX_LEN) {
+		tlv_len = T4_CC_MAX_LEN;
+		if (!read_bytes(ctx, NDEF_TAG_T4_CC_FILE, T4_CC_LEN, T4_CC_MAX_LEN, cc + T4_CC_LEN, T4_CC_MAX_LEN - T4_CC_LEN)) return false;
+	}
+	size_t nlen_size, max_size;
+	uint8_t read_access, write_access;
+	if (cc[7] == TLV_T4_FILE && cc[8] == 6) {
+		nlen_size    = 2;
+		max_size     = (cc[11] << 8) | cc[12];
+		read_access  = cc[13];
+		write_access = cc[14];
+	} else if (cc[7] == TLV_T4_EFILE && cc[8] == 8 && tlv_len >= 17) {
+		nlen_size    = 4;
+		max_size     = ((size_t) cc[11] << 24) | ((size_t) cc[12] << 16) | (cc[13] << 8) | cc[14];
+		read_access  = cc[15];
+		write_access = cc[16];
+	} else {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: No NDEF file control TLV found");
+		return fail(ctx, NDEF_ERR_INVALID);
+	}
+	if (read_access) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Tag does not allow reading (access 0x%02x)", read_access);
+		return fail(ctx, NDEF_ERR_INVALID);
+	}
+	if (max_size < nlen_size) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: NDEF file too small (%zu bytes)", max_size);
+		return fail(ctx, NDEF_ERR_INVALID);
+	}
+	out->file     = (cc[9] << 8) | cc[10];
+	out->writable = write_access == 0;
+	
+	// Read NLEN from the start of the NDEF file.
+	uint8_t nlen[4];
+	if (!read_bytes(ctx, out->file, 0, max_size, nlen, nlen_size)) return false;
+	size_t len = 0;
+	for (size_t i = 0; i < nlen_size; i++) {
+		len = (len << 8) | nlen[i];
+	}
+	if (len > max_size - nlen_size) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: NLEN is larger than the NDEF file (%zu bytes; maximum is %zu)", len, max_size - nlen_size);
+		return fail(ctx, NDEF_ERR_TRUNCATED);
+	}
+	out->offset   = nlen_size;
+	out->len      = len;
+	out->capacity = max_size - nlen_size;
+	return true;
+}
+
+// Parse the capability container and find the NDEF message, reading as little as possible.
+// Lock and memory control TLVs are skipped; reserved areas inside the NDEF TLV are not supported.
+bool ndef_tag_locate(ndef_tag ctx, ndef_tag_info *out) {
+	ctx->error = NDEF_OK;
+	if (ctx->type == NDEF_TAG_TYPE2) {
+		return locate_t2(ctx, out);
+	} else {
+		return locate_t4(ctx, out);
+	}
+}
+
+// Feed the NDEF message located by `ndef_tag_locate` into `parser` until it is done or stops.
+// Only the blocks covering the message are read, and reading ends as soon as the parser stops.
+// Returns the state of the parser, which is `NDEF_PARSER_MORE` if the message is cut short.
+ndef_parser_status ndef_tag_parse(ndef_tag ctx, const ndef_tag_info *info, ndef_parser parser) {
+	ctx->error = NDEF_OK;
+	size_t pos = info->offset;
+	size_t end = info->offset + info->len;
+	ndef_parser_status status = ndef_parser_get_status(parser);
+	while (pos < end && status == NDEF_PARSER_MORE) {
+		size_t avail;
+		const uint8_t *data = fetch(ctx, info->file, pos, end, &avail);
+		if (!data) return NDEF_PARSER_ERROR;
+		if (avail > end - pos) avail = end - pos;
+		status = ndef_parser_feed(parser, data, &avail);
+		pos   += avail;
+	}
+	return status;
+}
+
+// Read the NDEF message located by `ndef_tag_locate` into `buf`.
+// Fails if `cap` is less than `info->len`.
+bool ndef_tag_read_into(ndef_tag ctx, const ndef_tag_info *info, uint8_t *buf, size_t cap) {
+	ctx->error = NDEF_OK;
+	if (cap < info->len) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Not enough space (%zu bytes; expected %zu+ bytes)", cap, info->len);
+		return fail(ctx, NDEF_ERR_NO_SPACE);
+	}
+	return read_bytes(ctx, info->file, info->offset, info->offset + info->len, buf, info->len);
+}
+
+// Locate, read and decode the NDEF message on a tag.
+// Returns NULL if there is no valid message or when out of memory.
+ndef_ctx ndef_tag_decode(ndef_tag ctx) {
+	ndef_tag_info info;
+	if (!ndef_tag_locate(ctx, &info)) return NULL;
+	
+	// An empty NDEF TLV is an empty message.
+	ndef_ctx out = ndef_init();
+	if (!out) {
+		fail(ctx, NDEF_ERR_NO_MEM);
+		return NULL;
+	}
+	if (!info.len) return out;
+	
+	// Read the message, then decode it into a single allocation so the buffer can go.
+	uint8_t *buf = ndef_malloc(info.len, NDEF_ALLOC_PAYLOAD);
+	if (!buf) {
+		NDEF_LOG(NDEF_LOG_ERROR, "Error: Out of memory (allocating %zu bytes)", info.len);
+		fail(ctx, NDEF_ERR_NO_MEM);
+		ndef_destroy(out);
+		return NULL;
+	}
+	size_t len = info.len;
+	bool   ok  = ndef_tag_read_into(ctx, &info, buf, len);
+	if (ok && !ndef_decode_arena_into(out, buf, &len)) {
+		ok = fail(ctx, ndef_get_error(out, NULL));
+	}
+	ndef_free(buf, NDEF_ALLOC_PAYLOAD);
+	if (!ok) {
+		ndef_destroy(out);
+		return NULL;
+	}
+	return out;
+}
@@ -23,40 +23,176 @@
 */
 
 #include "ndef_text.h"
+#include "ndef_record_types.h"
 
 
 
 // Determine whether an NDEF record is a text record.
 bool ndef_record_is_text(ndef_record ctx) {
-	return ctx.tnf == NDEF_TNF_WELL_KNOWN && ctx.type_len == 1 && ctx.type[0] == 'T' && ctx.payload_len >= 4;
+	return ndef_record_kind(ctx) == NDEF_KIND_TEXT;
 }
 
-// Construct a `ndef_text` containing both the text and language from the record.
-// Returns NULL when out of memory, or when not a text record.
-ndef_text ndef_record_get_text(ndef_record ctx) {
+// Get the language and text of a text record without copying.
+// Returns false when not a text record.
+bool ndef_record_get_text_view(ndef_record ctx, ndef_text_view *out) {
 	// Check type.
-	if (!ndef_record_is_text(ctx)) return (ndef_text) { NULL, NULL };
+	if (!ndef_record_is_text(ctx)) return false;
+	// The payload may be missing, e.g. in an index view of a chunked record.
+	if (!ctx.payload || !ctx.payload_len) return false;
 	
 	// Parse the status byte.
 	uint_fast8_t lang_len = ctx.payload[0] & 0x3f;
-	// bool         is_utf16 = ctx.payload[0] & 0x80;
-	size_t       text_len = ctx.payload_len - lang_len - 1;
-	// TODO: UTF-16 to UTF-8 conversion.
+	if (1 + lang_len > ctx.payload_len) return false;
+	
+	out->lang     = (const char *) ctx.payload + 1;
+	out->lang_len = lang_len;
+	out->text     = ctx.payload + 1 + lang_len;
+	out->text_len = ctx.payload_len - lang_len - 1;
+	out->is_utf16 = ctx.payload[0] & 0x80;
+	return true;
+}
+
+// Convert UTF-16 text to UTF-8, honouring a byte order mark if present and big-endian otherwise.
+// The output is NUL-terminated if `cap` is nonzero, and is truncated at the last whole character that fits.
+// Returns the length of the full UTF-8 text, excluding the NUL terminator.
+size_t ndef_utf16_to_utf8(const uint8_t *in, size_t in_len, char *out, size_t cap) {
+	// Mask of the bits that are zero in four ASCII characters, for either byte order.
+	static const uint8_t ascii_mask_be[8] = { 0xff, 0x80, 0xff, 0x80, 0xff, 0x80, 0xff, 0x80 };
+	static const uint8_t ascii_mask_le[8] = { 0x80, 0xff, 0x80, 0xff, 0x80, 0xff, 0x80, 0xff };
+	
+	// Check for a byte order mark.
+	bool big_endian = true;
+	if (in_len >= 2 && in[0] == 0xff && in[1] == 0xfe) {
+		big_endian = false;
+		in += 2; in_len -= 2;
+	} else if (in_len >= 2 && in[0] == 0xfe && in[1] == 0xff) {
+		in += 2; in_len -= 2;
+	}
+	uint_fast8_t hi = big_endian ? 0 : 1;
+	uint_fast8_t lo = big_endian ? 1 : 0;
+	uint64_t ascii_mask;
+	memcpy(&ascii_mask, big_endian ? ascii_mask_be : ascii_mask_le, 8);
+	
+	// Leave room for the NUL terminator.
+	size_t avail   = cap ? cap - 1 : 0;
+	size_t len     = 0;
+	size_t written = 0;
+	bool   full    = false;
+	size_t i       = 0;
+	while (i + 1 < in_len) {
+		// Fast path: four ASCII characters at a time.
+		if (i + 8 <= in_len && (full || avail - len >= 4)) {
+			uint64_t word;
+			memcpy(&word, in + i, 8);
+			if (!(word & ascii_mask)) {
+				if (!full) {
+					out[len + 0] = in[i + lo + 0];
+					out[len + 1] = in[i + lo + 2];
+					out[len + 2] = in[i + lo + 4];
+					out[len + 3] = in[i + lo + 6];
+					written = len + 4;
+				}
+				len += 4;
+				i   += 8;
+				continue;
+			}
+		}
+		
+		// Decode one code point.
+		uint32_t unit = (in[i + hi] << 8) | in[i + lo];
+		i += 2;
+		uint32_t cp = unit;
+		if (unit >= 0xd800 && unit < 0xdc00 && i + 1 < in_len) {
+			uint32_t low = (in[i + hi] << 8) | in[i + lo];
+			if (low >= 0xdc00 && low < 0xe000) {
+				cp = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+				i += 2;
+			} else {
+				cp = 0xfffd;
+			}
+		} else if (unit >= 0xd800 && unit < 0xe000) {
+			// Unpaired surrogate.
+			cp = 0xfffd;
+		}
+		
+		// Encode it as UTF-8.
+		uint8_t      buf[4];
+		uint_fast8_t n;
+		if (cp < 0x80) {
+			buf[0] = cp;
+			n = 1;
+		} else if (cp < 0x800) {
+			buf[0] = 0xc0 | (cp >> 6);
+			buf[1] = 0x80 | (cp & 0x3f);
+			n = 2;
+		} else if (cp < 0x10000) {
+			buf[0] = 0xe0 | (cp >> 12);
+			buf[1] = 0x80 | ((cp >> 6) & 0x3f);
+			buf[2] = 0x80 | (cp & 0x3f);
+			n = 3;
+		} else {
+			buf[0] = 0xf0 | (cp >> 18);
+			buf[1] = 0x80 | ((cp >> 12) & 0x3f);
+			buf[2] = 0x80 | ((cp >> 6) & 0x3f);
+			buf[3] = 0x80 | (cp & 0x3f);
+			n = 4;
+		}
+		if (!full && avail - len >= n) {
+			memcpy(out + len, buf, n);
+			written = len + n;
+		} else {
+			full = true;
+		}
+		len += n;
+	}
+	
+	if (cap) out[written] = 0;
+	return len;
+}
+
+// Write the text of a text record as UTF-8 into `buf`, which is NUL-terminated if `cap` is nonzero.
+// Returns the length of the full text even if it was truncated, or 0 when not a text record.
+size_t ndef_record_get_text_into(ndef_record ctx, char *buf, size_t cap) {
+	ndef_text_view view;
+	if (!ndef_record_get_text_view(ctx, &view)) {
+		if (cap) *buf = 0;
+		return 0;
+	}
+	
+	// Convert UTF-16 text.
+	if (view.is_utf16) {
+		return ndef_utf16_to_utf8(view.text, view.text_len, buf, cap);
+	}
+	
+	// Copy UTF-8 text as much as fits.
+	if (cap) {
+		size_t len = view.text_len < cap - 1 ? view.text_len : cap - 1;
+		memcpy(buf, view.text, len);
+		buf[len] = 0;
+	}
+	return view.text_len;
+}
+
+// Construct a `ndef_text` containing both the text and language from the record.
+// Returns NULL when out of memory, or when not a text record.
+ndef_text ndef_record_get_text(ndef_record ctx) {
+	ndef_text_view view;
+	if (!ndef_record_get_text_view(ctx, &view)) return (ndef_text) { NULL, NULL };
 	
 	// Allocate memory.
-	char *lang = malloc(lang_len + 1);
+	size_t text_len = ndef_record_get_text_into(ctx, NULL, 0);
+	char *lang = ndef_malloc(view.lang_len + 1, NDEF_ALLOC_OUTPUT);
 	if (!lang) return (ndef_text) { NULL, NULL };
-	char *text = malloc(text_len + 1);
+	char *text = ndef_malloc(text_len + 1, NDEF_ALLOC_OUTPUT);
 	if (!text) {
-		free(lang);
+		ndef_free(lang, NDEF_ALLOC_OUTPUT);
 		return (ndef_text) { NULL, NULL };
 	}
 	
 	// Copy strings.
-	memcpy(lang, ctx.payload + 1, lang_len);
-	memcpy(text, ctx.payload + 1 + lang_len, text_len);
-	lang[lang_len] = 0;
-	text[text_len] = 0;
+	memcpy(lang, view.lang, view.lang_len);
+	lang[view.lang_len] = 0;
+	ndef_record_get_text_into(ctx, text, text_len + 1);
 	
 	// Return the pair of datas.
 	return (ndef_text) { lang, text };
@@ -64,32 +200,35 @@ ndef_text ndef_record_get_text(ndef_record ctx) {
 
 // Construct an NDEF record containing the given text and language.
 ndef_record ndef_record_new_text(ndef_text ctx) {
+	// Validity checks.
+	if (!ctx.lang || !ctx.text) {
+		return ndef_record_init();
+	}
 	size_t lang_len = strlen(ctx.lang);
 	size_t text_len = strlen(ctx.text);
-	
-	// Validity checks.
-	if (!ctx.lang || !ctx.text || lang_len < 2 || text_len) {
+	if (lang_len < 2 || lang_len > 0x3f) {
 		return ndef_record_init();
 	}
 	
 	// Allocate memory.
-	uint8_t *mem = malloc(1 + lang_len + text_len);
+	uint8_t *mem = ndef_malloc(1 + lang_len + text_len, NDEF_ALLOC_PAYLOAD);
 	if (!mem) return ndef_record_init();
 	
 	// Create payload.
 	*mem = 0x00 | lang_len;
 	memcpy(mem + 1, ctx.lang, lang_len);
 	memcpy(mem + 1 + lang_len, ctx.text, text_len);
-	uint8_t *type = malloc(1);
+	uint8_t *type = ndef_malloc(1, NDEF_ALLOC_FIELD);
 	if (!type) {
-		free(mem);
+		ndef_free(mem, NDEF_ALLOC_PAYLOAD);
 		return ndef_record_init();
 	}
-	*type = 'U';
+	*type = 'T';
 	
 	// Construct record.
 	return (ndef_record) {
 		.tnf			= NDEF_TNF_WELL_KNOWN,
+		.kind			= NDEF_KIND_TEXT,
 		.type_len		= 1,
 		.payload_len	= 1 + lang_len + text_len,
 		.id_len			= 0,
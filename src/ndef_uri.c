@@ -23,89 +23,103 @@
 */
 
 #include "ndef_uri.h"
+#include "ndef_record_types.h"
 
 
 
+#define ABBREV_STR(str) str,
+#define ABBREV_LEN(str) sizeof(str) - 1,
+
 // Table containing string values of URI abbreviations.
 const char *ndef_uri_abbrev_table[NDEF_URI_ABBREVMAX] = {
-	"",
-	"http://www.",
-	"https://www.",
-	"http://",
-	"https://",
-	"tel:",
-	"mailto:",
-	"ftp://anonymous:anonymous@",
-	"ftp://ftp.",
-	"ftps://",
-	"sftp://",
-	"smb://",
-	"nfs://",
-	"ftp://",
-	"dav://",
-	"news:",
-	"telnet://",
-	"imap:",
-	"rtsp://",
-	"urn:",
-	"pop:",
-	"sip:",
-	"sips:",
-	"tftp:",
-	"btspp://",
-	"btl2cap://",
-	"btgoep://",
-	"tcpobex://",
-	"irdaobex://",
-	"file://",
-	"urn:epc:id:",
-	"urn:epc:tag:",
-	"urn:epc:pat:",
-	"urn:epc:raw:",
-	"urn:epc:",
-	"urn:nfc:",
+	NDEF_URI_ABBREVS(ABBREV_STR)
+};
+
+// Table containing string lengths of URI abbreviations.
+const uint8_t ndef_uri_abbrev_len[NDEF_URI_ABBREVMAX] = {
+	NDEF_URI_ABBREVS(ABBREV_LEN)
 };
 
+// Abbreviations that can match a URI, by first character, from longest to shortest.
+static const uint8_t candidates_b[] = { NDEF_URI_ABBREV_btl2cap, NDEF_URI_ABBREV_btgoep, NDEF_URI_ABBREV_btspp, 0 };
+static const uint8_t candidates_d[] = { NDEF_URI_ABBREV_dav, 0 };
+static const uint8_t candidates_f[] = { NDEF_URI_ABBREV_ftp_anonymous_anonymous, NDEF_URI_ABBREV_ftp_ftp, NDEF_URI_ABBREV_ftps, NDEF_URI_ABBREV_file, NDEF_URI_ABBREV_ftp, 0 };
+static const uint8_t candidates_h[] = { NDEF_URI_ABBREV_https_www, NDEF_URI_ABBREV_http_www, NDEF_URI_ABBREV_https, NDEF_URI_ABBREV_http, 0 };
+static const uint8_t candidates_i[] = { NDEF_URI_ABBREV_irdaobex, NDEF_URI_ABBREV_imap, 0 };
+static const uint8_t candidates_m[] = { NDEF_URI_ABBREV_mailto, 0 };
+static const uint8_t candidates_n[] = { NDEF_URI_ABBREV_nfs, NDEF_URI_ABBREV_news, 0 };
+static const uint8_t candidates_p[] = { NDEF_URI_ABBREV_pop, 0 };
+static const uint8_t candidates_r[] = { NDEF_URI_ABBREV_rtsp, 0 };
+static const uint8_t candidates_s[] = { NDEF_URI_ABBREV_sftp, NDEF_URI_ABBREV_smb, NDEF_URI_ABBREV_sips, NDEF_URI_ABBREV_sip, 0 };
+static const uint8_t candidates_t[] = { NDEF_URI_ABBREV_tcpobex, NDEF_URI_ABBREV_telnet, NDEF_URI_ABBREV_tftp, NDEF_URI_ABBREV_tel, 0 };
+static const uint8_t candidates_u[] = { NDEF_URI_ABBREV_urn_epc_tag, NDEF_URI_ABBREV_urn_epc_pat, NDEF_URI_ABBREV_urn_epc_raw, NDEF_URI_ABBREV_urn_epc_id, NDEF_URI_ABBREV_urn_epc, NDEF_URI_ABBREV_urn_nfc, NDEF_URI_ABBREV_urn, 0 };
+
 
 
 // Determine whether an NDEF record is a URI record.
 bool ndef_record_is_uri(ndef_record ctx) {
-	return ctx.tnf == NDEF_TNF_WELL_KNOWN && ctx.type_len == 1 && ctx.type[0] == 'U' && ctx.payload_len >= 2;
+	return ndef_record_kind(ctx) == NDEF_KIND_URI;
+}
+
+// Get the expanded abbreviation and the remainder of a URI record without copying.
+// Returns false when not a URI record.
+bool ndef_record_get_uri_view(ndef_record ctx, ndef_uri_view *out) {
+	if (!ndef_record_is_uri(ctx)) return false;
+	// The payload may be missing, e.g. in an index view of a chunked record.
+	if (!ctx.payload || !ctx.payload_len) return false;
+	
+	// Decode abbreviation.
+	uint8_t abbrev = ctx.payload[0];
+	if (abbrev >= NDEF_URI_ABBREVMAX) return false;
+	
+	out->prefix     = ndef_uri_abbrev_table[abbrev];
+	out->prefix_len = ndef_uri_abbrev_len[abbrev];
+	out->rest       = (const char *) ctx.payload + 1;
+	out->rest_len   = strnlen(out->rest, ctx.payload_len - 1);
+	return true;
+}
+
+// Write the full URI from a URI record into `buf`, which is NUL-terminated if `cap` is nonzero.
+// Returns the length of the full URI even if it was truncated, or 0 when not a URI record.
+size_t ndef_record_get_uri_into(ndef_record ctx, char *buf, size_t cap) {
+	ndef_uri_view view;
+	if (!ndef_record_get_uri_view(ctx, &view)) {
+		if (cap) *buf = 0;
+		return 0;
+	}
+	
+	size_t len = view.prefix_len + view.rest_len;
+	if (cap) {
+		// Copy as much as fits.
+		size_t prefix_len = view.prefix_len < cap - 1 ? view.prefix_len : cap - 1;
+		size_t rest_len   = view.rest_len   < cap - 1 - prefix_len ? view.rest_len : cap - 1 - prefix_len;
+		memcpy(buf, view.prefix, prefix_len);
+		memcpy(buf + prefix_len, view.rest, rest_len);
+		buf[prefix_len + rest_len] = 0;
+	}
+	return len;
 }
 
 // Construct a string containing the full URI from a URI record.
 // Returns NULL when out of memory, or when not a URI record.
 char *ndef_record_get_uri(ndef_record ctx) {
-	if (ndef_record_is_uri(ctx)) {
-		if (ctx.payload[0]) {
-			// Decode abbreviation.
-			if (ctx.payload[0] >= NDEF_URI_ABBREVMAX) {
-				return NULL;
-			}
-			const char *abbrev = ndef_uri_abbrev_table[ctx.payload[0]];
-			// Allocate memory.
-			size_t cap = strlen(abbrev) + strnlen((char *) ctx.payload + 1, ctx.payload_len - 1);
-			char *mem = malloc(cap + 1);
-			if (!mem) return NULL;
-			// Copy string data.
-			strcpy(mem, abbrev);
-			strncat(mem, (char *) ctx.payload + 1, ctx.payload_len - 1);
-			mem[cap] = 0;
-			// Return buffer.
-			return mem;
-		} else {
-			// Just clone the string.
-			return strndup((char *) ctx.payload + 1, ctx.payload_len - 1);
-		}
-	} else {
-		return NULL;
-	}
+	ndef_uri_view view;
+	if (!ndef_record_get_uri_view(ctx, &view)) return NULL;
+	
+	// Allocate memory.
+	size_t cap = view.prefix_len + view.rest_len + 1;
+	char *mem = ndef_malloc(cap, NDEF_ALLOC_OUTPUT);
+	if (!mem) return NULL;
+	
+	// Copy string data.
+	ndef_record_get_uri_into(ctx, mem, cap);
+	return mem;
 }
 
 // Common URI record creator.
 static ndef_record new_uri(uint8_t abbrev, const char *uri) {
 	// Allocate memory.
-	char *mem = malloc(strlen(uri) + 2);
+	char *mem = ndef_malloc(strlen(uri) + 2, NDEF_ALLOC_PAYLOAD);
 	if (!mem) {
 		return ndef_record_init();
 	}
@@ -113,9 +127,9 @@ static ndef_record new_uri(uint8_t abbrev, const char *uri) {
 	// Create payload.
 	*mem = abbrev;
 	strcpy(mem + 1, uri);
-	uint8_t *type = malloc(1);
+	uint8_t *type = ndef_malloc(1, NDEF_ALLOC_FIELD);
 	if (!type) {
-		free(mem);
+		ndef_free(mem, NDEF_ALLOC_PAYLOAD);
 		return ndef_record_init();
 	}
 	*type = 'U';
@@ -123,6 +137,7 @@ static ndef_record new_uri(uint8_t abbrev, const char *uri) {
 	// Construct record.
 	return (ndef_record) {
 		.tnf			= NDEF_TNF_WELL_KNOWN,
+		.kind			= NDEF_KIND_URI,
 		.type_len		= 1,
 		.payload_len	= strlen(uri) + 1,
 		.id_len			= 0,
@@ -132,17 +147,38 @@ static ndef_record new_uri(uint8_t abbrev, const char *uri) {
 	};
 }
 
+// Get the abbreviations that may match a URI, longest first.
+static const uint8_t *find_candidates(const char *uri) {
+	switch (uri[0]) {
+		case 'b': return candidates_b;
+		case 'd': return candidates_d;
+		case 'f': return candidates_f;
+		case 'h': return candidates_h;
+		case 'i': return candidates_i;
+		case 'm': return candidates_m;
+		case 'n': return candidates_n;
+		case 'p': return candidates_p;
+		case 'r': return candidates_r;
+		case 's': return candidates_s;
+		case 't': return candidates_t;
+		case 'u': return candidates_u;
+		default:  return NULL;
+	}
+}
+
 // Construct an NDEF record containing the given URI.
 // The internal data may be abbreviated according to `ndef_uri_abbrev`.
 ndef_record ndef_record_new_uri(const char *uri) {
 	// Check abbreviation table.
 	uint_fast8_t match     = 0;
 	size_t       match_len = 0;
-	for (uint_fast8_t i = 1; i < NDEF_URI_ABBREVMAX; i++) {
-		size_t len = strlen(ndef_uri_abbrev_table[i]);
-		if (len > match_len && !strncmp(ndef_uri_abbrev_table[i], uri, len)) {
-			match     = i;
+	const uint8_t *candidates = find_candidates(uri);
+	for (; candidates && *candidates; candidates++) {
+		size_t len = ndef_uri_abbrev_len[*candidates];
+		if (!strncmp(ndef_uri_abbrev_table[*candidates] + 1, uri + 1, len - 1)) {
+			match     = *candidates;
 			match_len = len;
+			break;
 		}
 	}
 	
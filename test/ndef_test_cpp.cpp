@@ -0,0 +1,139 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+#include "ndef_test.h"
+#include "ndef.hpp"
+#include "ndef_uri.h"
+#include "ndef_text.h"
+#include "ndef_smartposter.h"
+
+#include <type_traits>
+
+
+
+static constexpr uint8_t uri_type_name[] = { 'U' };
+static constexpr ndef_record const_uri = [] {
+	ndef_record rec {};
+	rec.tnf      = NDEF_TNF_WELL_KNOWN;
+	rec.type_len = 1;
+	rec.type     = const_cast<uint8_t *>(uri_type_name);
+	return rec;
+}();
+static_assert(ndef::uri_type::match(const_uri));
+static_assert(!ndef::text_type::match(const_uri));
+static_assert(!ndef::smartposter_type::match(const_uri));
+static_assert(!std::is_copy_constructible_v<ndef::record> && std::is_nothrow_move_constructible_v<ndef::record>);
+static_assert(!std::is_copy_constructible_v<ndef::message> && std::is_nothrow_move_constructible_v<ndef::message>);
+
+// Encode the records of the wrapper test with the C API.
+static std::vector<uint8_t> c_encoding() {
+	ndef_ctx ctx = ndef_init();
+	ndef_append_mv(ctx, ndef_record_new_raw_uri("x"));
+	ndef_append_mv(ctx, ndef_record_new_uri("https://example.com/"));
+	ndef_append_mv(ctx, ndef_record_new_text(ndef_text { (char *) "en", (char *) "hello" }));
+	ndef_smartposter poster = ndef_smartposter_init();
+	poster.uri  = (char *) "tel:123";
+	poster.text = ndef_text { (char *) "nl", (char *) "bel" };
+	ndef_append_mv(ctx, ndef_record_new_smartposter(poster));
+	uint8_t *enc;
+	size_t   enc_len;
+	std::vector<uint8_t> out;
+	if (ndef_encode(ctx, &enc, &enc_len)) {
+		out.assign(enc, enc + enc_len);
+		ndef_free(enc, NDEF_ALLOC_OUTPUT);
+	}
+	ndef_destroy(ctx);
+	return out;
+}
+
+int main() {
+	ndef::message msg;
+	CHECK(msg && msg.empty());
+	CHECK(msg.append(ndef::record::uri("https://example.com/")));
+	CHECK(msg.append(ndef::record::text("en", "hello")));
+	CHECK(msg.append(ndef::record::smartposter("tel:123", "nl", "bel")));
+	ndef::record raw = ndef::record::raw_uri("x");
+	CHECK(raw);
+	CHECK(msg.insert(0, std::move(raw)));
+	CHECK(!raw);
+	
+	// The wrapper encodes exactly like the C API.
+	std::vector<uint8_t> enc = msg.encode();
+	CHECK(enc.size() == msg.encode_size());
+	CHECK(enc == c_encoding());
+	
+	// Views over a decoded message.
+	ndef::message view = ndef::message::decode_view(ndef::bytes(enc.data(), enc.size()));
+	CHECK(view && view.size() == 4);
+	size_t uris = 0, texts = 0, posters = 0;
+	for (ndef::record_view rec : view) {
+		if (rec.is<ndef::uri_type>()) {
+			uris ++;
+		} else if (rec.is<ndef::text_type>()) {
+			texts ++;
+			CHECK(std::string(rec.text()->lang.begin(), rec.text()->lang.end()) == "en");
+			CHECK(rec.text()->utf8() == "hello");
+		} else if (rec.is<ndef::smartposter_type>()) {
+			posters ++;
+			auto poster = rec.smartposter();
+			CHECK(poster);
+			if (poster) CHECK(ndef::message::decode_smartposter(*poster).size() == 2);
+		}
+	}
+	CHECK(uris == 2 && texts == 1 && posters == 1);
+	CHECK(view.end() - view.begin() == 4);
+	CHECK(view[0].uri()->str() == "x");
+	CHECK(view[1].uri()->str() == "https://example.com/");
+	
+	// Copies and edits.
+	ndef::message copy;
+	CHECK(copy.append_copy(view[2]));
+	ndef::record cloned = view[0].clone();
+	CHECK(cloned && cloned.view().type_str() == "U");
+	CHECK(copy.replace(0, std::move(cloned)));
+	CHECK(copy[0].uri()->str() == "x");
+	copy.erase(0);
+	CHECK(copy.empty());
+	
+	// Every way of decoding gives back the same encoding.
+	ndef::message arena = ndef::message::decode_arena(enc);
+	CHECK(arena.size() == 4 && arena.encode() == enc);
+	ndef::message decoded = ndef::message::decode(enc);
+	ndef::message clone   = decoded.clone();
+	CHECK(clone.encode() == enc);
+	CHECK(decoded.encode() == enc);
+	
+	uint8_t buf[512];
+	size_t  len;
+	CHECK(decoded.encode_into(buf, len) && len == enc.size());
+	CHECK(!decoded.encode_into(ndef::span<uint8_t>(buf, 3), len));
+	CHECK(decoded.error() != NDEF_OK);
+	
+	ndef::message moved = std::move(decoded);
+	CHECK(!decoded && moved);
+	CHECK(msg.decode_view_into(enc) && msg.size() == 4);
+	msg.clear();
+	CHECK(msg.empty());
+	
+	return TEST_RESULT();
+}
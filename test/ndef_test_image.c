@@ -0,0 +1,143 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+#include "ndef_test.h"
+#include "ndef_image.h"
+#include "ndef_uri.h"
+#include "ndef_text.h"
+
+#include <stdlib.h>
+
+
+
+// Encode `ctx` with ndef_encode and add the framing of `format` around it.
+static uint8_t *expected_image(ndef_ctx ctx, ndef_image_format format, size_t *len) {
+	uint8_t *msg;
+	size_t   msg_len;
+	if (!ndef_encode(ctx, &msg, &msg_len)) return NULL;
+	uint8_t *out = malloc(msg_len + 5);
+	size_t   pos = 0;
+	if (format == NDEF_IMAGE_T2_TLV) {
+		out[pos++] = 0x03;
+		if (msg_len < 0xFF) {
+			out[pos++] = msg_len;
+		} else {
+			out[pos++] = 0xFF;
+			out[pos++] = msg_len >> 8;
+			out[pos++] = msg_len;
+		}
+	} else if (format == NDEF_IMAGE_T4_NLEN) {
+		out[pos++] = msg_len >> 8;
+		out[pos++] = msg_len;
+	} else if (format == NDEF_IMAGE_T4_ENLEN) {
+		out[pos++] = msg_len >> 24;
+		out[pos++] = msg_len >> 16;
+		out[pos++] = msg_len >> 8;
+		out[pos++] = msg_len;
+	}
+	memcpy(out + pos, msg, msg_len);
+	pos += msg_len;
+	if (format == NDEF_IMAGE_T2_TLV) out[pos++] = 0xFE;
+	ndef_free(msg, NDEF_ALLOC_OUTPUT);
+	*len = pos;
+	return out;
+}
+
+// Compare reads of the image at pseudo-random offsets and lengths with the framed ndef_encode output.
+static void check_image(ndef_image img, ndef_ctx ctx, ndef_image_format format, uint32_t *seed) {
+	size_t   exp_len;
+	uint8_t *exp = expected_image(ctx, format, &exp_len);
+	CHECK(exp);
+	if (!exp) return;
+	CHECK(ndef_image_len(img) == exp_len);
+	
+	uint8_t buf[512];
+	for (int i = 0; i < 500; i++) {
+		*seed = *seed * 1103515245 + 12345;
+		size_t offset = (*seed >> 8) % (exp_len + 4);
+		*seed = *seed * 1103515245 + 12345;
+		size_t len    = (*seed >> 8) % sizeof(buf);
+		size_t want   = offset >= exp_len ? 0 : exp_len - offset < len ? exp_len - offset : len;
+		size_t got    = ndef_image_read_at(img, offset, buf, len);
+		CHECK(got == want);
+		if (got == want) CHECK_BYTES(buf, exp + offset, want);
+	}
+	
+	// Reading everything in one go from the start.
+	uint8_t *all = malloc(exp_len);
+	CHECK(ndef_image_read_at(img, 0, all, exp_len) == exp_len);
+	CHECK_BYTES(all, exp, exp_len);
+	free(all);
+	free(exp);
+}
+
+// Check every framing of a message with short and long payloads, before and after changing it.
+static void test_format(ndef_image_format format) {
+	static uint8_t big[1500];
+	for (size_t i = 0; i < sizeof(big); i++) big[i] = i * 7 + 3;
+	uint32_t seed = 0x1234 + format;
+	
+	ndef_ctx ctx = ndef_init();
+	ndef_append_mv(ctx, ndef_record_new_uri("https://example.com/image"));
+	ndef_record mime = ndef_record_init();
+	mime.tnf         = NDEF_TNF_MIME;
+	mime.type_len    = 24;
+	mime.type        = (uint8_t *) "application/octet-stream";
+	mime.payload_len = 300;
+	mime.payload     = big;
+	ndef_append(ctx, mime);
+	ndef_append_mv(ctx, ndef_record_new_text((ndef_text) { .lang = "en", .text = "Image" }));
+	
+	ndef_image img = ndef_image_init(ctx, format);
+	CHECK(img);
+	if (!img) {
+		ndef_destroy(ctx);
+		return;
+	}
+	check_image(img, ctx, format, &seed);
+	
+	// Growing a payload past 255 bytes changes the record header and the framing.
+	mime.payload_len = sizeof(big);
+	CHECK(ndef_replace(ctx, 1, mime));
+	check_image(img, ctx, format, &seed);
+	
+	// Removing a record shifts everything after it.
+	ndef_splice(ctx, 0);
+	check_image(img, ctx, format, &seed);
+	
+	// Chunking changes the encoding without changing the records.
+	ndef_set_chunk_size(ctx, 100);
+	check_image(img, ctx, format, &seed);
+	
+	CHECK(ndef_image_get_error(img) == NDEF_OK);
+	ndef_image_destroy(img);
+	ndef_destroy(ctx);
+}
+
+int main() {
+	test_format(NDEF_IMAGE_RAW);
+	test_format(NDEF_IMAGE_T2_TLV);
+	test_format(NDEF_IMAGE_T4_NLEN);
+	test_format(NDEF_IMAGE_T4_ENLEN);
+	return TEST_RESULT();
+}
@@ -0,0 +1,108 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+#include "ndef_test.h"
+#include "ndef_index.h"
+#include "ndef_uri.h"
+#include "ndef_text.h"
+#include "ndef_smartposter.h"
+#include "ndef_record_types.h"
+
+
+
+// A URI record split over two chunks, followed by a text record.
+static uint8_t chunked_msg[] = {
+	0xB1, 0x01, 0x04, 'U', 0x01, 'a', 'b', 'c',
+	0x16, 0x00, 0x03, 'd', 'e', 'f',
+	0x51, 0x01, 0x05, 'T', 0x02, 'e', 'n', 'h', 'i',
+};
+
+// Records split over chunks are not viewed in place.
+static void test_chunked() {
+	ndef_index idx = ndef_index_build(chunked_msg, sizeof(chunked_msg));
+	CHECK(idx);
+	if (!idx) return;
+	CHECK(ndef_index_len(idx) == 2);
+	
+	ndef_record rec;
+	CHECK(ndef_index_get(idx, 0, &rec));
+	CHECK(rec.tnf == NDEF_TNF_WELL_KNOWN && rec.type_len == 1 && rec.type[0] == 'U');
+	CHECK(!rec.payload && !rec.payload_len);
+	CHECK(rec.kind == NDEF_KIND_OTHER);
+	ndef_uri_view uri;
+	CHECK(!ndef_record_get_uri_view(rec, &uri));
+	
+	// Joining the chunks gives the same payload as decoding.
+	size_t len = sizeof(chunked_msg);
+	ndef_ctx ctx = ndef_decode(chunked_msg, &len);
+	CHECK(ctx && ndef_records_len(ctx) == 2);
+	uint8_t payload[16];
+	CHECK(ndef_index_read_payload(idx, 0, payload, sizeof(payload)) == 7);
+	CHECK(ndef_index_entry_get(idx, 0)->payload_len == 7);
+	if (ctx) {
+		const ndef_record *dec = ndef_records(ctx);
+		CHECK(dec[0].payload_len == 7);
+		CHECK_BYTES(payload, dec[0].payload, 7);
+		ndef_destroy(ctx);
+	}
+	
+	// Unchunked records after it are viewed in place.
+	CHECK(ndef_index_get(idx, 1, &rec));
+	ndef_text_view text;
+	CHECK(ndef_record_get_text_view(rec, &text));
+	CHECK(text.lang_len == 2 && text.text_len == 2 && !memcmp(text.text, "hi", 2));
+	CHECK(ndef_index_find_type(idx, NDEF_TNF_WELL_KNOWN, (const uint8_t *) "T", 1, 0) == 1);
+	
+	ndef_index_destroy(idx);
+}
+
+// The views refuse records without a payload.
+static void test_views_without_payload() {
+	uint8_t type_u = 'U', type_t = 'T', type_sp[] = { 'S', 'p' };
+	ndef_record rec = ndef_record_init();
+	rec.tnf         = NDEF_TNF_WELL_KNOWN;
+	rec.type_len    = 1;
+	rec.payload_len = 4;
+	
+	rec.type = &type_u;
+	rec.kind = ndef_classify(rec);
+	ndef_uri_view uri;
+	CHECK(!ndef_record_get_uri_view(rec, &uri));
+	
+	rec.type = &type_t;
+	rec.kind = ndef_classify(rec);
+	ndef_text_view text;
+	CHECK(!ndef_record_get_text_view(rec, &text));
+	
+	rec.type     = type_sp;
+	rec.type_len = 2;
+	rec.kind     = ndef_classify(rec);
+	ndef_smartposter_view sp;
+	CHECK(!ndef_record_get_smartposter_view(rec, &sp));
+}
+
+int main() {
+	test_chunked();
+	test_views_without_payload();
+	return TEST_RESULT();
+}
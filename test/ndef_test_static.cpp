@@ -0,0 +1,100 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+#include "ndef_test.h"
+#include "ndef_static.hpp"
+#include "ndef_uri.h"
+#include "ndef_text.h"
+
+
+
+// Every URI abbreviation path, a text record, a long record, an ID and a record without payload.
+NDEF_STATIC_MESSAGE(mixed_msg,
+	ndef_static::uri("https://www.example.com/pair?id=1"),
+	ndef_static::text("en-US", "Hold to pair"),
+	ndef_static::raw_uri("tel:123"),
+	ndef_static::uri("urn:epc:tag:xyz"),
+	ndef_static::uri("mystery"),
+	ndef_static::raw(NDEF_TNF_MIME, "text/plain", std::array<uint8_t, 300> { 1, 2, 3 }),
+	ndef_static::with_id(ndef_static::uri("sips:a"), "id7"),
+	ndef_static::raw(NDEF_TNF_EXTERNAL, "example.com:empty", "")
+);
+
+// A message of a single record, which is both the first and the last.
+NDEF_STATIC_MESSAGE(single_msg, ndef_static::raw(NDEF_TNF_EXTERNAL, "a.b:c", "x"));
+
+static_assert(mixed_msg[0] == (NDEF_FLAG_MB | NDEF_FLAG_SR | NDEF_TNF_WELL_KNOWN));
+static_assert(single_msg.size() == 3 + 5 + 1);
+
+// Check that `msg` is byte for byte what ndef_encode makes of `ctx`, then destroy `ctx`.
+template<size_t N>
+static void check_same(ndef_ctx ctx, const std::array<uint8_t, N> &msg) {
+	uint8_t *enc;
+	size_t   enc_len;
+	CHECK(ndef_encode(ctx, &enc, &enc_len));
+	CHECK(enc_len == N);
+	if (enc_len == N) CHECK_BYTES(enc, msg.data(), N);
+	ndef_free(enc, NDEF_ALLOC_OUTPUT);
+	ndef_destroy(ctx);
+}
+
+int main() {
+	static uint8_t long_payload[300] = { 1, 2, 3 };
+	
+	ndef_ctx ctx = ndef_init();
+	ndef_append_mv(ctx, ndef_record_new_uri("https://www.example.com/pair?id=1"));
+	ndef_append_mv(ctx, ndef_record_new_text(ndef_text { (char *) "en-US", (char *) "Hold to pair" }));
+	ndef_append_mv(ctx, ndef_record_new_raw_uri("tel:123"));
+	ndef_append_mv(ctx, ndef_record_new_uri("urn:epc:tag:xyz"));
+	ndef_append_mv(ctx, ndef_record_new_uri("mystery"));
+	ndef_record mime = ndef_record_init();
+	mime.tnf         = NDEF_TNF_MIME;
+	mime.type_len    = 10;
+	mime.type        = (uint8_t *) "text/plain";
+	mime.payload_len = sizeof(long_payload);
+	mime.payload     = long_payload;
+	ndef_append(ctx, mime);
+	ndef_record with_id = ndef_record_new_uri("sips:a");
+	with_id.id_len      = 3;
+	with_id.id          = (uint8_t *) "id7";
+	with_id.borrowed   |= NDEF_BORROW_ID;
+	ndef_append_mv(ctx, with_id);
+	ndef_record empty = ndef_record_init();
+	empty.tnf         = NDEF_TNF_EXTERNAL;
+	empty.type_len    = 17;
+	empty.type        = (uint8_t *) "example.com:empty";
+	ndef_append(ctx, empty);
+	check_same(ctx, mixed_msg);
+	
+	ctx = ndef_init();
+	ndef_record single = ndef_record_init();
+	single.tnf         = NDEF_TNF_EXTERNAL;
+	single.type_len    = 5;
+	single.type        = (uint8_t *) "a.b:c";
+	single.payload_len = 1;
+	single.payload     = (uint8_t *) "x";
+	ndef_append(ctx, single);
+	check_same(ctx, single_msg);
+	
+	return TEST_RESULT();
+}
@@ -0,0 +1,152 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+#include "ndef_test.h"
+#include "ndef_stream.h"
+#include "ndef_uri.h"
+
+#include <stdlib.h>
+
+
+
+// Number of calls to the counting allocator.
+static size_t allocs;
+
+static void *count_alloc(void *cookie, size_t size, ndef_alloc_kind kind) {
+	(void) cookie;
+	(void) kind;
+	allocs ++;
+	return malloc(size);
+}
+
+static void *count_realloc(void *cookie, void *ptr, size_t size, ndef_alloc_kind kind) {
+	(void) cookie;
+	(void) kind;
+	allocs ++;
+	return realloc(ptr, size);
+}
+
+static void count_free(void *cookie, void *ptr, ndef_alloc_kind kind) {
+	(void) cookie;
+	(void) kind;
+	free(ptr);
+}
+
+// Allocator that counts allocations.
+static const ndef_allocator count_allocator = { count_alloc, count_realloc, count_free, NULL };
+
+// Raw records expected from the parser, in order.
+typedef struct {
+	// Expected raw records.
+	const ndef_raw_record *records;
+	// Number of expected raw records.
+	size_t                 records_len;
+	// Number of records seen so far.
+	size_t                 seen;
+} expect;
+
+// Compare every record the parser emits with the next expected one.
+static bool expect_record(void *cookie, const ndef_raw_record *record) {
+	expect *exp = cookie;
+	CHECK(exp->seen < exp->records_len);
+	if (exp->seen >= exp->records_len) return false;
+	const ndef_raw_record *want = exp->records + exp->seen++;
+	
+	CHECK(record->tnf == want->tnf);
+	CHECK(record->flag_begin == want->flag_begin && record->flag_end == want->flag_end);
+	CHECK(record->flag_chunked == want->flag_chunked);
+	CHECK(record->type_len == want->type_len && record->payload_len == want->payload_len && record->id_len == want->id_len);
+	if (record->type_len)    CHECK_BYTES(record->type,    want->type,    record->type_len);
+	if (record->payload_len) CHECK_BYTES(record->payload, want->payload, record->payload_len);
+	if (record->id_len)      CHECK_BYTES(record->id,      want->id,      record->id_len);
+	return true;
+}
+
+// Build a message with a short record, a large chunked record and a large unchunked one.
+static bool make_message(uint8_t **data, size_t *len) {
+	static uint8_t big[3000];
+	for (size_t i = 0; i < sizeof(big); i++) big[i] = i * 7;
+	
+	ndef_ctx ctx = ndef_init();
+	if (!ctx) return false;
+	ndef_record mime = ndef_record_init();
+	mime.tnf         = NDEF_TNF_MIME;
+	mime.type_len    = 10;
+	mime.type        = (uint8_t *) "text/plain";
+	mime.payload_len = sizeof(big);
+	mime.payload     = big;
+	mime.id_len      = 2;
+	mime.id          = (uint8_t *) "id";
+	
+	bool ok = ndef_append_mv(ctx, ndef_record_new_uri("https://example.com/"))
+		&& ndef_append(ctx, mime);
+	ndef_set_chunk_size(ctx, 1000);
+	ok = ok && ndef_encode(ctx, data, len);
+	ndef_destroy(ctx);
+	return ok;
+}
+
+// Feeding one byte at a time gives the same records as `ndef_decode`, without reallocating per byte.
+static void test_bytewise() {
+	uint8_t *data;
+	size_t   len;
+	CHECK(make_message(&data, &len));
+	if (!data) return;
+	
+	size_t   dec_len = len;
+	ndef_ctx dec     = ndef_decode(data, &dec_len);
+	CHECK(dec);
+	if (!dec) return;
+	expect exp = { ndef_raw_records(dec), ndef_raw_records_len(dec), 0 };
+	CHECK(exp.records_len == 4);
+	
+	ndef_set_allocator(&count_allocator);
+	allocs = 0;
+	ndef_parser parser = ndef_parser_init(expect_record, &exp);
+	CHECK(parser);
+	ndef_parser_status status = NDEF_PARSER_MORE;
+	for (size_t i = 0; parser && i < len; i++) {
+		size_t one = 1;
+		status = ndef_parser_feed(parser, data + i, &one);
+		CHECK(one == 1);
+		if (status != NDEF_PARSER_MORE) {
+			CHECK(i == len - 1);
+			break;
+		}
+	}
+	CHECK(status == NDEF_PARSER_DONE);
+	CHECK(exp.seen == exp.records_len);
+	CHECK(ndef_parser_offset(parser) == len);
+	// The buffer grows a handful of times, not once per byte.
+	CHECK(allocs <= 16);
+	if (parser) ndef_parser_destroy(parser);
+	ndef_set_allocator(NULL);
+	
+	ndef_destroy(dec);
+	ndef_free(data, NDEF_ALLOC_OUTPUT);
+}
+
+int main() {
+	test_bytewise();
+	return TEST_RESULT();
+}
@@ -0,0 +1,190 @@
+/*
+	MIT License
+
+	Copyright (c) 2023 Julian Scheffers
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+#include "ndef_test.h"
+#include "ndef_tag.h"
+#include "ndef_uri.h"
+#include "ndef_text.h"
+
+
+
+// Emulated tag memory.
+typedef struct {
+	// Type 2 memory, or the Type 4 NDEF file.
+	uint8_t *mem;
+	// Length of `mem`.
+	size_t   mem_len;
+	// Type 4 capability container file.
+	uint8_t *cc;
+	// Length of `cc`.
+	size_t   cc_len;
+	// Number of reads made.
+	size_t   reads;
+} fake_tag;
+
+// Serve reads from the emulated memory, failing reads past its end.
+static bool fake_read(void *cookie, uint16_t file, size_t offset, uint8_t *buf, size_t len) {
+	fake_tag      *tag = cookie;
+	const uint8_t *mem = tag->mem;
+	size_t         cap = tag->mem_len;
+	if (file == NDEF_TAG_T4_CC_FILE) {
+		mem = tag->cc;
+		cap = tag->cc_len;
+	} else if (file != (tag->cc ? 0xE104 : 0)) {
+		return false;
+	}
+	if (offset > cap || len > cap - offset) return false;
+	memcpy(buf, mem + offset, len);
+	tag->reads ++;
+	return true;
+}
+
+// Encode a message with a URI, a text and a payload of `big_len` bytes.
+static uint8_t *make_message(size_t big_len, size_t *len) {
+	static uint8_t big[1024];
+	for (size_t i = 0; i < sizeof(big); i++) big[i] = i * 13;
+	ndef_ctx ctx = ndef_init();
+	ndef_append_mv(ctx, ndef_record_new_uri("https://example.com/tag"));
+	ndef_append_mv(ctx, ndef_record_new_text((ndef_text) { .lang = "en", .text = "On a tag" }));
+	ndef_record mime = ndef_record_init();
+	mime.tnf         = NDEF_TNF_MIME;
+	mime.type_len    = 24;
+	mime.type        = (uint8_t *) "application/octet-stream";
+	mime.payload_len = big_len;
+	mime.payload     = big;
+	ndef_append(ctx, mime);
+	uint8_t *data = NULL;
+	if (!ndef_encode(ctx, &data, len)) *len = 0;
+	ndef_destroy(ctx);
+	return data;
+}
+
+// Check that decoding the tag gives back `msg`.
+static void check_decode(fake_tag *tag, ndef_tag_type type, const uint8_t *msg, size_t msg_len) {
+	ndef_tag reader = ndef_tag_init(type, fake_read, tag);
+	CHECK(reader);
+	if (!reader) return;
+	
+	ndef_tag_info info;
+	CHECK(ndef_tag_locate(reader, &info));
+	CHECK(info.len == msg_len);
+	CHECK(info.writable);
+	
+	uint8_t buf[1200];
+	CHECK(ndef_tag_read_into(reader, &info, buf, sizeof(buf)));
+	CHECK_BYTES(buf, msg, msg_len);
+	
+	ndef_tag_invalidate(reader);
+	ndef_ctx ctx = ndef_tag_decode(reader);
+	CHECK(ctx);
+	if (ctx) {
+		uint8_t *enc;
+		size_t   enc_len;
+		CHECK(ndef_records_len(ctx) == 3);
+		CHECK(ndef_encode(ctx, &enc, &enc_len));
+		CHECK(enc_len == msg_len);
+		CHECK_BYTES(enc, msg, msg_len);
+		ndef_free(enc, NDEF_ALLOC_OUTPUT);
+		ndef_destroy(ctx);
+	}
+	CHECK(ndef_tag_get_error(reader) == NDEF_OK);
+	ndef_tag_destroy(reader);
+}
+
+// Type 2 tags with a short and a long NDEF TLV behind a lock control and a NULL TLV.
+static void test_type2(size_t big_len) {
+	size_t   msg_len;
+	uint8_t *msg = make_message(big_len, &msg_len);
+	CHECK(msg);
+	if (!msg) return;
+	
+	uint8_t mem[16 + 1200] = { 0 };
+	size_t  data_size = (sizeof(mem) - 16) / 8 * 8;
+	mem[12] = 0xE1;
+	mem[13] = 0x10;
+	mem[14] = data_size / 8 > 0xFF ? 0xFF : data_size / 8;
+	mem[15] = 0x00;
+	size_t pos = 16;
+	static const uint8_t lock_tlv[] = { 0x01, 0x03, 0xA0, 0x10, 0x44, 0x00 };
+	memcpy(mem + pos, lock_tlv, sizeof(lock_tlv));
+	pos += sizeof(lock_tlv);
+	mem[pos++] = 0x03;
+	if (msg_len < 0xFF) {
+		mem[pos++] = msg_len;
+	} else {
+		mem[pos++] = 0xFF;
+		mem[pos++] = msg_len >> 8;
+		mem[pos++] = msg_len;
+	}
+	memcpy(mem + pos, msg, msg_len);
+	mem[pos + msg_len] = 0xFE;
+	
+	fake_tag tag = { .mem = mem, .mem_len = sizeof(mem) };
+	check_decode(&tag, NDEF_TAG_TYPE2, msg, msg_len);
+	
+	// A tag that is not NDEF formatted has no message.
+	mem[12] = 0x00;
+	ndef_tag reader = ndef_tag_init(NDEF_TAG_TYPE2, fake_read, &tag);
+	CHECK(reader && !ndef_tag_decode(reader));
+	CHECK(reader && ndef_tag_get_error(reader) == NDEF_ERR_INVALID);
+	if (reader) ndef_tag_destroy(reader);
+	
+	ndef_free(msg, NDEF_ALLOC_OUTPUT);
+}
+
+// A Type 4 tag with a plain NDEF file control TLV.
+static void test_type4() {
+	size_t   msg_len;
+	uint8_t *msg = make_message(600, &msg_len);
+	CHECK(msg);
+	if (!msg) return;
+	
+	uint8_t file[1024] = { 0 };
+	file[0] = msg_len >> 8;
+	file[1] = msg_len;
+	memcpy(file + 2, msg, msg_len);
+	uint8_t cc[] = {
+		0x00, 0x0F, 0x20, 0x00, 0x3B, 0x00, 0x34,
+		0x04, 0x06, 0xE1, 0x04, sizeof(file) >> 8, sizeof(file) & 0xFF, 0x00, 0x00,
+	};
+	
+	fake_tag tag = { .mem = file, .mem_len = sizeof(file), .cc = cc, .cc_len = sizeof(cc) };
+	check_decode(&tag, NDEF_TAG_TYPE4, msg, msg_len);
+	
+	// NLEN may not exceed the file.
+	file[0] = 0x04;
+	ndef_tag reader = ndef_tag_init(NDEF_TAG_TYPE4, fake_read, &tag);
+	ndef_tag_info info;
+	CHECK(reader && !ndef_tag_locate(reader, &info));
+	CHECK(reader && ndef_tag_get_error(reader) == NDEF_ERR_TRUNCATED);
+	if (reader) ndef_tag_destroy(reader);
+	
+	ndef_free(msg, NDEF_ALLOC_OUTPUT);
+}
+
+int main() {
+	test_type2(40);
+	test_type2(500);
+	test_type4();
+	return TEST_RESULT();
+}